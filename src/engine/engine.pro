@@ -32,6 +32,17 @@ SOURCES += engine.cpp \
     events/Event.cpp \
     events/EventManager.cpp \
     events/EventManagerImp.cpp \
+    events/EventListenerTable.cpp \
+    events/EventQueue.cpp \
+    events/EventTrace.cpp \
+    events/RealtimeEventQueue.cpp \
+    events/EventSerializer.cpp \
+    events/EventRecorder.cpp \
+    events/EventTimerWheel.cpp \
+    events/EventFactory.cpp \
+    events/SharedEventBus.cpp \
+    utilities/memorypool.cpp \
+    utilities/clock.cpp \
     process/process.cpp \
     process/processmanager.cpp
 
@@ -49,8 +60,23 @@ HEADERS += engine.h \
     events/EventManager.h \
     events/FastDelegate.h \
     events/EventManagerImp.h \
+    events/EventListenerTable.h \
+    events/EventQueue.h \
+    events/EventPool.h \
+    events/EventTrace.h \
+    events/RealtimeEventQueue.h \
+    events/EventSerializer.h \
+    events/EventRecorder.h \
+    events/EventTimerWheel.h \
+    events/EventFactory.h \
+    events/SharedEventBus.h \
+    events/TypedEventChannel.h \
+    utilities/memorypool.h \
+    utilities/clock.h \
     process/process.h \
-    process/processmanager.h
+    process/processmanager.h \
+    process/processpool.h \
+    process/coroutineprocess.h
 unix {
     target.path = /usr/lib
     INSTALLS += target
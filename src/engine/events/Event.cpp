@@ -2,21 +2,30 @@
 
 namespace genesis {
 /*
-const EventType QuitMessage::sk_EventType( 0x2750D117 );
-const EventType OgreWindowCreatedMessage::sk_EventType( 0xA89497DB );
-const EventType WindowResizeMessage::sk_EventType( 0xDD03B93F );
+GEN_DEFINE_EVENT_TYPE(QuitMessage);
+GEN_DEFINE_EVENT_TYPE(OgreWindowCreatedMessage);
+GEN_DEFINE_EVENT_TYPE(WindowResizeMessage);
 
-const EventType KeyDownMessage::sk_EventType( 0x88EADB1D );
-const EventType KeyUpMessage::sk_EventType( 0xCC1A3297 );
-const EventType MouseButtonDownMessage::sk_EventType( 0x98CC26D4 );
-const EventType MouseButtonUpMessage::sk_EventType( 0xF236A098 );
-const EventType MouseMovementMessage::sk_EventType( 0xD5168D3A );
+GEN_DEFINE_EVENT_TYPE(KeyDownMessage);
+GEN_DEFINE_EVENT_TYPE(KeyUpMessage);
+GEN_DEFINE_EVENT_TYPE(MouseButtonDownMessage);
+GEN_DEFINE_EVENT_TYPE(MouseButtonUpMessage);
+GEN_DEFINE_EVENT_TYPE(MouseMovementMessage);
 
-const EventType NewSceneManagerMessage::sk_EventType( 0x983B64F3 );
-const EventType NewCameraAndViewportMessage::sk_EventType( 0x3D91371B );
-const EventType AddGraphicalObjectMessage::sk_EventType( 0xAA43BE00 );
-const EventType RemoveGraphicalObjectMessage::sk_EventType( 0x8035506C );
+GEN_DEFINE_EVENT_TYPE(NewSceneManagerMessage);
+GEN_DEFINE_EVENT_TYPE(NewCameraAndViewportMessage);
+GEN_DEFINE_EVENT_TYPE(AddGraphicalObjectMessage);
+GEN_DEFINE_EVENT_TYPE(RemoveGraphicalObjectMessage);
 
-const EventType CreateGUIWindowMessage::sk_EventType( 0x1331E1C4 );
+GEN_DEFINE_EVENT_TYPE(CreateGUIWindowMessage);
+
+// events the factory can create need a default constructor
+void RegisterEngineEvents() {
+	g_eventFactory.registerEvents<QuitMessage>();
+}//RegisterEngineEvents
+
+static_assert(EventTypesAreUnique<QuitMessage, OgreWindowCreatedMessage, WindowResizeMessage, KeyDownMessage, KeyUpMessage,
+	MouseButtonDownMessage, MouseButtonUpMessage, MouseMovementMessage, NewSceneManagerMessage, NewCameraAndViewportMessage,
+	AddGraphicalObjectMessage, RemoveGraphicalObjectMessage, CreateGUIWindowMessage>::value, "Engine event type id collision");
 */
 }
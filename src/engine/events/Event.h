@@ -1,6 +1,7 @@
 #ifndef EVENT_H
 #define EVENT_H
 
+#include "EventFactory.h"
 #include "EventManager.h"
 
 namespace genesis {
@@ -10,7 +11,7 @@ namespace genesis {
 ////////////////////////////////////////////////////////////////////////////////
 class QuitMessage : public genesis::BaseEventData {
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(QuitMessage);
 
 	QuitMessage() {	}
 	~QuitMessage() { }
@@ -18,8 +19,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const std::string getName() const { return "QuitMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new QuitMessage()); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -35,7 +36,7 @@ private:
 	const unsigned int				m_WindowHeight;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(OgreWindowCreatedMessage);
 
 	OgreWindowCreatedMessage( Ogre::RenderWindow* window, size_t handle, unsigned int width, unsigned int height ) : m_pWindow(window), m_WindowHandle(handle), m_WindowWidth(width), m_WindowHeight(height) {	}
 	~OgreWindowCreatedMessage() { }
@@ -43,8 +44,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "OgreWindowCreatedMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new OgreWindowCreatedMessage(m_pWindow, m_WindowHandle, m_WindowWidth, m_WindowHeight)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const Ogre::RenderWindow* getRenderWindow() { return m_pWindow; }
 	const size_t getWindowHandle() { return m_WindowHandle;	}
@@ -62,7 +63,7 @@ private:
 	const unsigned int				m_WindowHeight;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(WindowResizeMessage);
 
 	WindowResizeMessage( unsigned int width, unsigned int height ) : m_WindowWidth(width), m_WindowHeight(height) {	}
 	~WindowResizeMessage() { }
@@ -70,8 +71,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "WindowResizeMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new WindowResizeMessage(m_WindowWidth, m_WindowHeight)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const unsigned int getWindowWidth() { return m_WindowWidth; }
 	const unsigned int getWindowHeight() { return m_WindowHeight; }
@@ -87,7 +88,7 @@ private:
 	const unsigned int				m_Text;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(KeyDownMessage);
 
 	KeyDownMessage( genesis::GenesisKeyCode key, unsigned int text ) : m_Key(key), m_Text(text) { }
 	~KeyDownMessage() { }
@@ -95,8 +96,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "KeyDownMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new KeyDownMessage(m_Key, m_Text)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const genesis::GenesisKeyCode getKey() { return m_Key; }
 	const unsigned int getText() { return m_Text; }
@@ -108,7 +109,7 @@ private:
 	const unsigned int				m_Text;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(KeyUpMessage);
 
 	KeyUpMessage( genesis::GenesisKeyCode key, unsigned int text ) : m_Key(key), m_Text(text) { }
 	~KeyUpMessage() { }
@@ -116,8 +117,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "KeyUpMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new KeyUpMessage(m_Key, m_Text)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const genesis::GenesisKeyCode getKey() { return m_Key; }
 	const unsigned int getText() { return m_Text; }
@@ -130,7 +131,7 @@ private:
 	const int		m_Zabs, m_Zrel;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(MouseMovementMessage);
 
 	MouseMovementMessage( int xabs, int yabs, int zabs, int xrel, int yrel, int zrel ) : m_Xabs(xabs), m_Yabs(yabs), m_Zabs(zabs),
 																							m_Xrel(xrel), m_Yrel(yrel), m_Zrel(zrel) { }
@@ -139,8 +140,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "MouseMovementMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new MouseMovementMessage(m_Xabs, m_Yabs, m_Zabs, m_Xrel, m_Yrel, m_Zrel)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const int getXabs() { return m_Xabs;}
 	const int getYabs() { return m_Yabs;}
@@ -155,7 +156,7 @@ private:
 	const genesis::GenesisMouseButtonID	m_Button;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(MouseButtonDownMessage);
 
 	MouseButtonDownMessage( genesis::GenesisMouseButtonID button ) : m_Button(button) { }
 	~MouseButtonDownMessage() { }
@@ -163,8 +164,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "MouseButtonDownMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new MouseButtonDownMessage(m_Button)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const genesis::GenesisMouseButtonID getButton() { return m_Button; }
 };
@@ -174,7 +175,7 @@ private:
 	const genesis::GenesisMouseButtonID	m_Button;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(MouseButtonUpMessage);
 
 	MouseButtonUpMessage( genesis::GenesisMouseButtonID button ) : m_Button(button) { }
 	~MouseButtonUpMessage() { }
@@ -182,8 +183,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "MouseButtonUpMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new MouseButtonUpMessage(m_Button)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const genesis::GenesisMouseButtonID getButton() { return m_Button; }
 };
@@ -197,7 +198,7 @@ private:
 	String					m_SceneName;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(NewSceneManagerMessage);
 
 	NewSceneManagerMessage( OgreSceneType sceneType, String sceneName ) : m_SceneType(sceneType), m_SceneName(sceneName) { }
 	~NewSceneManagerMessage() { }
@@ -205,8 +206,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "NewSceneManagerMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new NewSceneManagerMessage( m_SceneType, m_SceneName)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const OgreSceneType getSceneType() { return  m_SceneType; }
 	const String getSceneName() { return m_SceneName; }
@@ -221,7 +222,7 @@ private:
 	viewportstat	m_VPS;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(NewCameraAndViewportMessage);
 
 	NewCameraAndViewportMessage( String cameraName, float camX, float camY, float camZ, viewportstat vps ) : m_CameraName(cameraName), m_CameraX(camX),
 																											m_CameraY(camY), m_CameraZ(camZ), m_VPS(vps) { }
@@ -230,8 +231,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "NewCameraAndViewportMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new NewCameraAndViewportMessage(m_CameraName, m_CameraX, m_CameraY, m_CameraZ, m_VPS)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const String getCameraName() { return m_CameraName; }
 	const float getCameraX() { return m_CameraX; }
@@ -246,7 +247,7 @@ private:
 	std::shared_ptr<IObject>	m_pParentObject;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(AddGraphicalObjectMessage);
 
 	AddGraphicalObjectMessage( std::shared_ptr<IObject> object, std::shared_ptr<IObject> parent ) : m_pNewObject(object), m_pParentObject(parent) { }
 	~AddGraphicalObjectMessage() { }
@@ -254,8 +255,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "AddGraphicalObjectMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new AddGraphicalObjectMessage(m_pNewObject, m_pParentObject)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const std::shared_ptr<IObject> getNewObject() { return m_pNewObject; }
 	const std::shared_ptr<IObject> getParentObject() { return m_pParentObject; }
@@ -266,7 +267,7 @@ private:
 	std::shared_ptr<IObject>	m_pObject;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(RemoveGraphicalObjectMessage);
 
 	RemoveGraphicalObjectMessage( std::shared_ptr<IObject> object ) : m_pObject(object) { }
 	~RemoveGraphicalObjectMessage() { }
@@ -274,8 +275,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "RemoveGraphicalObjectMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new RemoveGraphicalObjectMessage(m_pObject)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const std::shared_ptr<IObject> getNewObject() { return m_pObject; }
 };
@@ -288,7 +289,7 @@ private:
 	guiwindowproperties		m_Properties;
 
 public:
-	static const genesis::EventType sk_EventType;
+	GEN_EVENT_TYPE(CreateGUIWindowMessage);
 
 	CreateGUIWindowMessage( guiwindowproperties properties ) : m_Properties(properties) { }
 	~CreateGUIWindowMessage() { }
@@ -296,8 +297,8 @@ public:
 	virtual const genesis::EventType& getEventType() const { return sk_EventType; }
 	virtual const genesis::String getName() const { return "CreateGUIWindowMessage"; }
 	virtual genesis::IEventDataPtr copy() const { return genesis::IEventDataPtr(new CreateGUIWindowMessage(m_Properties)); }
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual bool serialize( genesis::EventWriter& out ) const { return BaseEventData::serialize(out); }
+	virtual bool deserialize( genesis::EventReader& in ) { return BaseEventData::deserialize(in); }
 
 	const guiwindowproperties getProperties() { return m_Properties; }
 };
@@ -0,0 +1,78 @@
+#include <cstdlib>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include "EventFactory.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+EventFactory::EventFactory() {
+	rehash(16);
+}//EventFactory::EventFactory
+
+bool EventFactory::registerCreator( const EventType& type, EventCreateFunc create, const std::string& name ) {
+	unsigned int index = getIndex(type);
+	if( index != kINVALID_INDEX ) {
+		if( m_creators[index].create != create ) {
+			std::string msg = "Event type id collision between ";
+			msg += m_creators[index].name;
+			msg += " and ";
+			msg += name;
+			GEN_ERROR(msg);
+			return false;
+		}
+		return true;  // already registered
+	}
+
+	if( (m_creators.size() + 1) * 2 > m_slots.size() )
+		rehash(m_slots.size() * 2);
+
+	Creator creator;
+	creator.type = type;
+	creator.create = create;
+	creator.name = name;
+	m_creators.push_back(creator);
+
+	size_t mask = m_slots.size() - 1;
+	size_t i = (size_t)type & mask;
+	while( m_slots[i].index != kINVALID_INDEX )
+		i = (i + 1) & mask;
+	m_slots[i].type = type;
+	m_slots[i].index = (unsigned int)(m_creators.size() - 1);
+
+	return true;
+}//EventFactory::registerCreator
+
+void EventFactory::rehash( size_t numSlots ) {
+	Slot empty;
+	empty.type = 0;
+	empty.index = kINVALID_INDEX;
+	m_slots.assign(numSlots, empty);
+
+	size_t mask = numSlots - 1;
+	for( unsigned int index = 0; index < m_creators.size(); ++index ) {
+		size_t i = (size_t)m_creators[index].type & mask;
+		while( m_slots[i].index != kINVALID_INDEX )
+			i = (i + 1) & mask;
+		m_slots[i].type = m_creators[index].type;
+		m_slots[i].index = index;
+	}
+}//EventFactory::rehash
+
+std::string EventFactory::ClassName( const std::type_info& type ) {
+	std::string name = type.name();
+#ifdef __GNUG__
+	int status = 0;
+	char* pDemangled = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+	if( pDemangled ) {
+		if( status == 0 )
+			name = pDemangled;
+		free(pDemangled);
+	}
+#endif
+	return name;
+}//EventFactory::ClassName
+
+}
@@ -0,0 +1,128 @@
+#ifndef EVENT_FACTORY_H
+#define EVENT_FACTORY_H
+
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+#include "EventManager.h"
+#include "EventPool.h"
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// Compile time event type ids.  An event's type is the 32 bit FNV-1a hash of its class name, so ids no longer have to
+// be picked by hand and are the same in every build and on both ends of a connection.
+//---------------------------------------------------------------------------------------------------------------------
+constexpr unsigned int EventTypeHash( const char* str, unsigned int hash = 2166136261u ) {
+	return (*str == 0) ? hash : EventTypeHash(str + 1, (hash ^ (unsigned char)(*str)) * 16777619u);
+}//EventTypeHash
+
+// Use inside the event class.  The type stays a constant expression, so it can be used in static_asserts and switches.
+#define GEN_EVENT_TYPE(eventClass) static const genesis::EventType sk_EventType = genesis::EventTypeHash(#eventClass)
+// Use once in the event's .cpp, because getEventType() returns sk_EventType by reference
+#define GEN_DEFINE_EVENT_TYPE(eventClass) const genesis::EventType eventClass::sk_EventType
+
+// true if no two of the event classes have the same type id
+template <EventType kType, class... TEvents>
+struct EventTypeNotIn : std::true_type {};
+
+template <EventType kType, class TFirst, class... TRest>
+struct EventTypeNotIn<kType, TFirst, TRest...>
+	: std::integral_constant<bool, (kType != TFirst::sk_EventType) && EventTypeNotIn<kType, TRest...>::value> {};
+
+template <class... TEvents>
+struct EventTypesAreUnique : std::true_type {};
+
+template <class TFirst, class... TRest>
+struct EventTypesAreUnique<TFirst, TRest...>
+	: std::integral_constant<bool, EventTypeNotIn<TFirst::sk_EventType, TRest...>::value && EventTypesAreUnique<TRest...>::value> {};
+
+typedef IEventDataPtr (*EventCreateFunc)();
+
+// the creator registerEvent() uses; the event needs a default constructor and gets its contents from deserialize()
+template <class TEvent>
+IEventDataPtr CreatePooledEvent() {
+	return MakeEvent<TEvent>();
+}//CreatePooledEvent
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventFactory class
+//
+// Creates events from their type ids, for deserialized and remote events.  Each registered type is given a dense index
+// in registration order and its creator is stored at that index.  Ids are mapped to indices with a small open
+// addressing table; the ids are hashes already, so the low bits pick the starting slot and a lookup is usually a
+// single probe with no hashing and no pointer chasing.
+//
+// Register all of a module's events with one registerEvents<...>() call so their ids are checked against each other at
+// compile time.  Ids registered separately are still checked at run time.
+//---------------------------------------------------------------------------------------------------------------------
+class EventFactory {
+public:
+	static const unsigned int kINVALID_INDEX = 0xffffffff;
+
+private:
+	struct Slot {
+		EventType		type;
+		unsigned int	index;  // kINVALID_INDEX if the slot is empty
+	};
+
+	struct Creator {
+		EventType		type;
+		EventCreateFunc	create;
+		std::string		name;  // for error messages
+	};
+
+	std::vector<Slot>		m_slots;  // power of two size, kept at most half full
+	std::vector<Creator>	m_creators;  // indexed by dense index
+
+public:
+	EventFactory();
+
+	bool registerCreator( const EventType& type, EventCreateFunc create, const std::string& name );
+
+	// without a name, the demangled class name is used
+	template <class TEvent>
+	bool registerEvent( const char* name = "" ) {
+		return registerCreator(TEvent::sk_EventType, &CreatePooledEvent<TEvent>, (name && *name) ? std::string(name) : ClassName(typeid(TEvent)));
+	}
+
+	template <class... TEvents>
+	void registerEvents() {
+		static_assert(EventTypesAreUnique<TEvents...>::value, "Two of these events have the same type id");
+		bool results[] = { true, registerEvent<TEvents>()... };
+		(void)results;
+	}
+
+	IEventDataPtr create( const EventType& type ) const {
+		unsigned int index = getIndex(type);
+		return (index == kINVALID_INDEX) ? IEventDataPtr() : m_creators[index].create();
+	}
+
+	unsigned int getIndex( const EventType& type ) const {
+		size_t mask = m_slots.size() - 1;
+		for( size_t i = (size_t)type & mask; ; i = (i + 1) & mask ) {
+			const Slot& slot = m_slots[i];
+			if( slot.index == kINVALID_INDEX || slot.type == type )
+				return slot.index;
+		}
+	}
+
+	bool isRegistered( const EventType& type ) const { return (getIndex(type) != kINVALID_INDEX); }
+	unsigned int getNumRegistered() const { return (unsigned int)m_creators.size(); }
+
+private:
+	void rehash( size_t numSlots );
+
+	static std::string ClassName( const std::type_info& type );
+};
+
+extern EventFactory g_eventFactory;
+
+#define REGISTER_EVENT(eventClass) genesis::g_eventFactory.registerEvent<eventClass>(#eventClass)
+#define CREATE_EVENT(eventType) genesis::g_eventFactory.create(eventType)
+
+}
+
+#endif /* EVENT_FACTORY_H */
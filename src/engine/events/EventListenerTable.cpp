@@ -0,0 +1,206 @@
+#include "EventListenerTable.h"
+
+namespace genesis {
+
+EventListenerTable::EventListenerTable()
+	: m_pTypes(new TypeMap()),
+	  m_epoch(0)
+{
+	m_readers[0].store(0);
+	m_readers[1].store(0);
+}//EventListenerTable::EventListenerTable
+
+EventListenerTable::~EventListenerTable()
+{
+	for( auto it = m_slots.begin(); it != m_slots.end(); ++it ) {
+		const ListenerList* pList = (*it)->load();
+		if( pList ) {
+			for( auto listenerIt = pList->begin(); listenerIt != pList->end(); ++listenerIt )
+				delete *listenerIt;
+			delete pList;
+		}
+		delete *it;
+	}
+
+	for( auto it = m_retired.begin(); it != m_retired.end(); ++it )
+		Destroy(it->kind, it->pObject);
+
+	delete m_pTypes.load();
+}//EventListenerTable::~EventListenerTable
+
+bool EventListenerTable::add( const EventType& type, const EventListenerDelegate& eventDelegate, ListenerConcurrency concurrency, unsigned int& outNumListeners ) {
+	tbb::spin_mutex::scoped_lock lock(m_writeMutex);
+
+	const TypeMap* pTypes = m_pTypes.load(std::memory_order_relaxed);
+	Slot* pSlot = NULL;
+	auto findIt = pTypes->find(type);
+	if( findIt != pTypes->end() ) {
+		pSlot = findIt->second;
+	}
+	else {
+		// first listener of the type; publish a copy of the type map with a new slot
+		pSlot = new Slot();
+		pSlot->pList.store(NULL);
+		pSlot->instant.store(0);
+		m_slots.push_back(pSlot);
+
+		TypeMap* pNewTypes = new TypeMap(*pTypes);
+		(*pNewTypes)[type] = pSlot;
+		m_pTypes.store(pNewTypes, std::memory_order_release);
+		retire(RETIRED_TYPES, pTypes);
+	}
+
+	const ListenerList* pList = pSlot->pList.load(std::memory_order_relaxed);
+	if( pList ) {
+		for( auto it = pList->begin(); it != pList->end(); ++it ) {
+			if( eventDelegate == (*it)->delegate ) {
+				outNumListeners = (unsigned int)pList->size();
+				return false;
+			}
+		}
+	}
+
+	Listener* pListener = new Listener();
+	pListener->delegate = eventDelegate;
+	pListener->concurrency = concurrency;
+	pListener->active.store(true);
+
+	ListenerList* pNewList = pList ? new ListenerList(*pList) : new ListenerList();
+	pNewList->push_back(pListener);
+	pSlot->pList.store(pNewList, std::memory_order_release);
+	if( pList )
+		retire(RETIRED_LIST, pList);
+
+	outNumListeners = (unsigned int)pNewList->size();
+	reclaimLocked();
+	return true;
+}//EventListenerTable::add
+
+bool EventListenerTable::remove( const EventType& type, const EventListenerDelegate& eventDelegate, unsigned int& outNumListeners ) {
+	tbb::spin_mutex::scoped_lock lock(m_writeMutex);
+
+	outNumListeners = 0;
+	const TypeMap* pTypes = m_pTypes.load(std::memory_order_relaxed);
+	auto findIt = pTypes->find(type);
+	if( findIt == pTypes->end() )
+		return false;
+
+	Slot* pSlot = findIt->second;
+	const ListenerList* pList = pSlot->pList.load(std::memory_order_relaxed);
+	if( !pList )
+		return false;
+
+	for( auto it = pList->begin(); it != pList->end(); ++it ) {
+		Listener* pListener = *it;
+		if( !(eventDelegate == pListener->delegate) )
+			continue;
+
+		pListener->active.store(false, std::memory_order_release);
+
+		ListenerList* pNewList = NULL;
+		if( pList->size() > 1 ) {
+			pNewList = new ListenerList();
+			pNewList->reserve(pList->size() - 1);
+			pNewList->insert(pNewList->end(), pList->begin(), it);
+			pNewList->insert(pNewList->end(), it + 1, pList->end());
+			outNumListeners = (unsigned int)pNewList->size();
+		}
+		pSlot->pList.store(pNewList, std::memory_order_release);
+		retire(RETIRED_LIST, pList);
+		retire(RETIRED_LISTENER, pListener);
+
+		reclaimLocked();
+		return true;
+	}
+
+	outNumListeners = (unsigned int)pList->size();
+	return false;
+}//EventListenerTable::remove
+
+void EventListenerTable::reclaim() {
+	tbb::spin_mutex::scoped_lock lock;
+	if( lock.try_acquire(m_writeMutex) )
+		reclaimLocked();
+}//EventListenerTable::reclaim
+
+bool EventListenerTable::hasListeners( const EventType& type ) const {
+	ReadScope scope(*this);
+	return (find(type) != NULL);
+}//EventListenerTable::hasListeners
+
+const EventListenerTable::ListenerList* EventListenerTable::find( const EventType& type ) const {
+	const Slot* pSlot = findSlot(type);
+	return pSlot ? pSlot->load() : NULL;
+}//EventListenerTable::find
+
+const EventListenerTable::Slot* EventListenerTable::findSlot( const EventType& type ) const {
+	const TypeMap* pTypes = m_pTypes.load(std::memory_order_acquire);
+	auto findIt = pTypes->find(type);
+	return (findIt != pTypes->end()) ? findIt->second : NULL;
+}//EventListenerTable::findSlot
+
+//---------------------------------------------------------------------------------------------------------------------
+// The reader count has to be raised before the epoch is read for the last time, or a writer could move the epoch on
+// and free something in between.  If the epoch changed while the count was going up, the count went to the wrong
+// parity, so try again.
+//---------------------------------------------------------------------------------------------------------------------
+unsigned int EventListenerTable::enterRead() const {
+	for( ;; ) {
+		unsigned long long epoch = m_epoch.load();
+		unsigned int parity = (unsigned int)(epoch & 1);
+		m_readers[parity].fetch_add(1);
+		if( m_epoch.load() == epoch )
+			return parity;
+		m_readers[parity].fetch_sub(1);
+	}
+}//EventListenerTable::enterRead
+
+void EventListenerTable::retire( RetiredKind kind, const void* pObject ) {
+	Retired retired;
+	retired.epoch = m_epoch.load(std::memory_order_relaxed);
+	retired.kind = kind;
+	retired.pObject = pObject;
+	m_retired.push_back(retired);
+}//EventListenerTable::retire
+
+//---------------------------------------------------------------------------------------------------------------------
+// Moving from epoch e to e + 1 needs the readers of e - 1, which share a count with e + 1, to have left.  So once the
+// epoch is two past an object's, every reader that could have seen it is gone.
+//---------------------------------------------------------------------------------------------------------------------
+void EventListenerTable::reclaimLocked() {
+	if( m_retired.empty() )
+		return;
+
+	for( unsigned int i = 0; i < 2; ++i ) {
+		unsigned long long epoch = m_epoch.load();
+		if( m_readers[(epoch + 1) & 1].load() != 0 )
+			break;
+		m_epoch.store(epoch + 1);
+	}
+
+	unsigned long long epoch = m_epoch.load();
+	size_t numKept = 0;
+	for( size_t i = 0; i < m_retired.size(); ++i ) {
+		if( m_retired[i].epoch + 2 <= epoch )
+			Destroy(m_retired[i].kind, m_retired[i].pObject);
+		else
+			m_retired[numKept++] = m_retired[i];
+	}
+	m_retired.resize(numKept);
+}//EventListenerTable::reclaimLocked
+
+void EventListenerTable::Destroy( RetiredKind kind, const void* pObject ) {
+	switch( kind ) {
+		case RETIRED_LIST:
+			delete (const ListenerList*)pObject;  // the listeners in it are retired on their own
+			break;
+		case RETIRED_LISTENER:
+			delete (const Listener*)pObject;
+			break;
+		case RETIRED_TYPES:
+			delete (const TypeMap*)pObject;
+			break;
+	}
+}//EventListenerTable::Destroy
+
+}
@@ -0,0 +1,132 @@
+#ifndef EVENT_LISTENER_TABLE_H
+#define EVENT_LISTENER_TABLE_H
+
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include <tbb/spin_mutex.h>
+
+#include "EventManager.h"
+
+namespace genesis {
+
+// Handler timing for one listener.  Worker threads update it too, so the counters are relaxed atomics.
+struct EventListenerCounters {
+	std::atomic<unsigned long long>		calls;
+	std::atomic<unsigned long long>		totalNs;
+	std::atomic<unsigned long long>		maxNs;
+
+	EventListenerCounters() : calls(0), totalNs(0), maxNs(0) {}
+
+	void record( unsigned long long ns ) {
+		calls.fetch_add(1, std::memory_order_relaxed);
+		totalNs.fetch_add(ns, std::memory_order_relaxed);
+		unsigned long long prevMax = maxNs.load(std::memory_order_relaxed);
+		while( ns > prevMax && !maxNs.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed) ) {}
+	}
+
+	void reset() {
+		calls.store(0, std::memory_order_relaxed);
+		totalNs.store(0, std::memory_order_relaxed);
+		maxNs.store(0, std::memory_order_relaxed);
+	}
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventListenerTable class
+//
+// The listeners of an event manager, read by dispatch without taking a lock and changed by add()/remove() from any
+// thread, including from inside a listener.  Each type's list is copied on write and the copy published with a single
+// pointer store, so a dispatch walking a list is never disturbed by a change to it.  Writers only lock out each other.
+//
+// Lists that have been replaced, and the listeners removed from them, can't be freed while a reader may still hold
+// them.  Readers announce themselves with a ReadScope, which bumps a reader count for the current epoch.  Replaced
+// objects are tagged with the epoch they were retired in, and the epoch only moves on once the readers of the epoch
+// before have left, so anything two epochs old is unreachable.  Writers and reclaim() check this without ever waiting:
+// what can't be freed yet is simply left for a later try.
+//
+// remove() also clears the listener's active flag, which dispatch checks right before each call.  A listener removed
+// during a dispatch, by itself or by another listener, is not called again, even for the event being dispatched.
+//---------------------------------------------------------------------------------------------------------------------
+class EventListenerTable {
+public:
+	struct Listener {
+		EventListenerDelegate	delegate;
+		ListenerConcurrency		concurrency;
+		EventListenerCounters	counters;
+		std::atomic<bool>		active;
+	};
+
+	typedef std::vector<Listener*> ListenerList;  // never changed once published
+
+	struct Slot {
+		std::atomic<const ListenerList*>	pList;  // NULL when the type has no listeners
+		mutable std::atomic<unsigned long long>	instant;  // instantEvent() calls that found listeners; any thread counts them
+
+		const ListenerList* load() const { return pList.load(std::memory_order_acquire); }
+	};
+
+	typedef std::unordered_map<EventType, Slot*> TypeMap;  // also copied on write, when a type is first added
+
+	class ReadScope {
+		const EventListenerTable&	m_table;
+		unsigned int				m_parity;
+
+	public:
+		explicit ReadScope( const EventListenerTable& table ) : m_table(table), m_parity(table.enterRead()) {}
+		~ReadScope() { m_table.exitRead(m_parity); }
+	};
+
+private:
+	enum RetiredKind {
+		RETIRED_LIST,
+		RETIRED_LISTENER,
+		RETIRED_TYPES,
+	};
+
+	struct Retired {
+		unsigned long long	epoch;
+		RetiredKind			kind;
+		const void*			pObject;
+	};
+
+	std::atomic<const TypeMap*>			m_pTypes;
+	mutable std::atomic<unsigned long long>	m_epoch;
+	mutable std::atomic<unsigned int>	m_readers[2];  // readers that entered in an even/odd epoch
+
+	// writers only
+	tbb::spin_mutex			m_writeMutex;
+	std::vector<Slot*>		m_slots;  // never freed before the table, like the types that own them
+	std::vector<Retired>	m_retired;
+
+public:
+	EventListenerTable();
+	~EventListenerTable();
+
+	// any thread; outNumListeners is the type's listener count afterwards
+	bool add( const EventType& type, const EventListenerDelegate& eventDelegate, ListenerConcurrency concurrency, unsigned int& outNumListeners );
+	bool remove( const EventType& type, const EventListenerDelegate& eventDelegate, unsigned int& outNumListeners );
+	void reclaim();  // frees whatever readers can no longer reach, unless a writer is busy
+	bool hasListeners( const EventType& type ) const;
+
+	// only inside a ReadScope, and only valid until it ends
+	const ListenerList* find( const EventType& type ) const;
+	const Slot* findSlot( const EventType& type ) const;  // NULL if the type never had listeners
+	const TypeMap& getTypes() const { return *m_pTypes.load(std::memory_order_acquire); }
+
+private:
+	unsigned int enterRead() const;
+	void exitRead( unsigned int parity ) const { m_readers[parity].fetch_sub(1); }
+
+	void retire( RetiredKind kind, const void* pObject );
+	void reclaimLocked();
+	static void Destroy( RetiredKind kind, const void* pObject );
+
+	EventListenerTable( const EventListenerTable& );
+	EventListenerTable& operator=( const EventListenerTable& );
+};
+
+}
+
+#endif /* EVENT_LISTENER_TABLE_H */
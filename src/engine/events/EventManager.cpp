@@ -1,10 +1,22 @@
+#include "EventFactory.h"
 #include "EventManager.h"
+#include "EventSerializer.h"
 #include "utilities/logger.h"
 
 namespace genesis {
 
 static IEventManager* g_pEventManager = NULL;
-//GenericObjectFactory<IEventData, EventType> g_eventFactory;
+EventFactory g_eventFactory;
+
+bool BaseEventData::serialize( EventWriter& out ) const {
+	return out.write(m_TimeStamp);
+}//BaseEventData::serialize
+
+bool BaseEventData::deserialize( EventReader& in ) {
+	if( in.getVersion() < BASEEVENTDATA_SCHEMA_VERSION )
+		return true;  // written before the timestamp was
+	return in.read(m_TimeStamp);
+}//BaseEventData::deserialize
 
 IEventManager::IEventManager( const std::string name, bool global ) {
 	if( global ) {
@@ -2,24 +2,57 @@
 #define EVENT_MANAGER_H
 
 #include <memory>
-#include <strstream>
-#include <tbb/concurrent_queue.h>
+#include <string>
 
 #include "FastDelegate.h"
 
 namespace genesis {
 
 class IEventData;
+class EventWriter;
+class EventReader;
 typedef unsigned long EventType;
 typedef std::shared_ptr<IEventData> IEventDataPtr;
-typedef fastdelegate::FastDelegate1<IEventDataPtr> EventListenerDelegate;
-typedef tbb::concurrent_queue<IEventDataPtr> ThreadSafeEventQueue;
+typedef fastdelegate::FastDelegate1<const IEventDataPtr&> EventListenerDelegate;  // by reference, so dispatch doesn't touch the refcount
+typedef fastdelegate::FastDelegate2<const IEventDataPtr&, const IEventDataPtr&, IEventDataPtr> EventMergeDelegate;  // (pending, incoming) -> merged
+typedef unsigned long long EventTimerHandle;  // 0 is never a valid handle
+
+// What a realtime producer thread's queue does when it's full (see queueEventThreadSafe()).  BLOCK waits for the
+// thread that runs update(), so it never waits on that thread itself, and gives up after REALTIME_BLOCK_TIMEOUT_MS in
+// case updates have stopped; either way the event is then rejected like DROP_NEWEST and counted in blockFailed.
+enum RealtimeOverflowPolicy {
+	REALTIME_OVERFLOW_DROP_OLDEST,  // discard the oldest pending event to make room
+	REALTIME_OVERFLOW_DROP_NEWEST,  // reject the new event
+	REALTIME_OVERFLOW_BLOCK,  // wait (bounded) until the main loop drains some events
+	REALTIME_OVERFLOW_COALESCE,  // replace the newest pending event of the same type, otherwise drop the oldest
+};
+
+// Where a listener may be called from when its events are dispatched by update().  Worker listeners may only queue
+// events with queueEventThreadSafe(); queueEvent() is redirected there with an error, since the queues aren't locked.
+enum ListenerConcurrency {
+	LISTENER_MAIN_THREAD,  // called inline on the thread running update(), in queue order
+	LISTENER_ANY_THREAD,  // may be called on a worker, concurrently with anything, including itself
+	LISTENER_SERIALIZED_PER_TYPE,  // called on a worker, one event at a time and in queue order for each event type
+};
 
-// TODO can i make this work?
-// Macro for event registration
-//extern GenericObjectFactory<IEventData, EventType> g_eventFactory;
-//#define REGISTER_EVENT(eventClass) g_eventFactory.Register<eventClass>(eventClass::sk_EventType)
-//#define CREATE_EVENT(eventType) g_eventFactory.Create(eventType)
+// How queueEvent() treats an event when one of the same type is already waiting in the queue
+enum EventCoalescePolicy {
+	EVENT_COALESCE_NONE,  // queue every event
+	EVENT_COALESCE_REPLACE,  // the new event takes the pending one's place in the queue; latest value wins
+	EVENT_COALESCE_MERGE,  // the pending event is replaced by the result of a merge delegate
+	EVENT_COALESCE_KEEP_FIRST,  // the new event is dropped
+};
+
+// Queued events are dispatched from one lane per priority, highest first, so bulk gameplay traffic can't hold up
+// input or quit events.  Each lane can be given its own share of update()'s time budget.
+enum EventPriority {
+	EVENT_PRIORITY_CRITICAL = 0,  // input, quit and anything else the frame can't wait for
+	EVENT_PRIORITY_HIGH,
+	EVENT_PRIORITY_NORMAL,  // the default
+	EVENT_PRIORITY_BULK,  // high volume gameplay notifications that can slip a frame
+
+	EVENT_NUM_PRIORITIES
+};
 
 class IEventData {
 public:
@@ -30,14 +63,20 @@ public:
 	virtual IEventDataPtr copy() const = 0;
 	virtual const std::string getName() const = 0;
 
-	//for network input/output
-	virtual void serialize( std::ostrstream& out ) const = 0;
-	virtual void deserialize( std::istrstream& in ) = 0;
+	// for network input/output and recording; see EventSerializer.h.  Bump the schema version whenever the serialized
+	// fields change, and have deserialize() check in.getVersion() so older recordings can still be read.
+	virtual unsigned short getSchemaVersion() const = 0;
+	virtual bool serialize( EventWriter& out ) const = 0;
+	virtual bool deserialize( EventReader& in ) = 0;
 };
 
+// The base class serializes the timestamp, so events with fields of their own should call BaseEventData::serialize()
+// and deserialize() first and number their schema versions from BASEEVENTDATA_SCHEMA_VERSION up.
+const unsigned short BASEEVENTDATA_SCHEMA_VERSION = 2;  // 1 didn't have the timestamp
+
 class BaseEventData : public IEventData {
 protected:
-	const float		m_TimeStamp;
+	float			m_TimeStamp;
 
 public:
 	explicit BaseEventData( const float timeStamp = 0.0f ) : m_TimeStamp(timeStamp) {}
@@ -45,9 +84,11 @@ public:
 
 	virtual const EventType& getEventType() const = 0;
 	virtual float getTimeStamp() const { return m_TimeStamp; }
+	void setTimeStamp( float timeStamp ) { m_TimeStamp = timeStamp; }
 
-	virtual void serialize( std::ostrstream& out ) const {}
-	virtual void deserialize( std::istrstream& in ) {}
+	virtual unsigned short getSchemaVersion() const { return BASEEVENTDATA_SCHEMA_VERSION; }
+	virtual bool serialize( EventWriter& out ) const;
+	virtual bool deserialize( EventReader& in );
 };
 
 class IEventManager {
@@ -57,15 +98,31 @@ public:
 	explicit IEventManager( const std::string name, bool global );
 	virtual ~IEventManager();
 
-	virtual bool addListener( const EventListenerDelegate& eventDelegate, const EventType& type ) = 0;
+	virtual bool addListener( const EventListenerDelegate& eventDelegate, const EventType& type, ListenerConcurrency concurrency = LISTENER_MAIN_THREAD ) = 0;
 	virtual bool removeListener( const EventListenerDelegate& eventDelegate, const EventType& type ) = 0;
 
 	virtual bool instantEvent( const IEventDataPtr& event ) = 0;
 	virtual bool queueEvent( const IEventDataPtr& event ) = 0;
 	virtual bool queueEventThreadSafe( const IEventDataPtr& event ) = 0;
+
+	// Timed events are held back and passed to queueEvent() by the first update() at or after their time, which is in
+	// microseconds on Clock::nowUs().  Both return 0 on failure.
+	virtual EventTimerHandle queueEventAt( const IEventDataPtr& event, unsigned long long timeMicros ) = 0;
+	virtual EventTimerHandle queueEventAfter( const IEventDataPtr& event, unsigned long delayMicros ) = 0;
+	virtual bool cancelTimedEvent( EventTimerHandle handle ) = 0;  // false if it already fired or was cancelled
+
+	virtual bool registerRealtimeProducer( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy ) = 0;
+	virtual void unregisterRealtimeProducer() = 0;
 	virtual bool abortEvent( const EventType& type, bool allOfType = false ) = 0;
+	virtual bool setCoalescePolicy( const EventType& type, EventCoalescePolicy policy, const EventMergeDelegate& merge = EventMergeDelegate() ) = 0;
+	virtual bool setEventPriority( const EventType& type, EventPriority priority ) = 0;
+	virtual void setLaneBudget( EventPriority lane, unsigned long maxMicros ) = 0;
+
+	// captures every event passed to queueEvent() to a file that EventReplayer can play back
+	virtual bool startRecording( const std::string& fileName ) = 0;
+	virtual void stopRecording() = 0;
 
-	virtual bool update( unsigned long maxMillis = kINFINITE ) = 0;
+	virtual bool update( unsigned long maxMicros = kINFINITE ) = 0;  // the budget is in microseconds
 
 	static IEventManager* Get();
 };
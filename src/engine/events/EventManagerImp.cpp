@@ -1,212 +1,762 @@
+#include <algorithm>
+#include <cstdio>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
 #include "EventManagerImp.h"
+#include "EventTrace.h"
+#include "utilities/clock.h"
 #include "utilities/logger.h"
 
 namespace genesis {
 
-#ifdef WIN32
-#include <windows.h>
-#else
-unsigned long GetTickCount() {
-	struct timespec ts;
-	unsigned long tick = 0;
-	if( clock_gettime(CLOCK_MONOTONIC,&ts) != 0 ) {
-		GEN_ERROR("Unable to get current tick count");
-	}
-	tick = ts.tv_nsec / 1000000;
-	tick += ts.tv_sec * 1000;
-	return tick;
-}
-#endif
+const unsigned long long EVENTMANAGER_NO_DEADLINE = ~0ULL;
+
+static unsigned long long DeadlineNs( unsigned long long nowNs, unsigned long maxMicros ) {
+	if( maxMicros == IEventManager::kINFINITE )
+		return EVENTMANAGER_NO_DEADLINE;
+	return nowNs + ((unsigned long long)maxMicros * 1000);
+}//DeadlineNs
+
+// Listeners removed since the list was read are skipped; returns true if the listener was called
+static inline bool CallListener( EventListenerTable::Listener& listener, const IEventDataPtr& pEvent ) {
+	if( !listener.active.load(std::memory_order_acquire) )
+		return false;
+
+	unsigned long long startNs = Clock::nowNs();
+	listener.delegate(pEvent);
+	listener.counters.record(Clock::nowNs() - startNs);
+	return true;
+}//CallListener
+
+// set while this thread is calling an ANY_THREAD or SERIALIZED_PER_TYPE listener
+static thread_local bool t_inWorkerListener = false;
+
+static inline bool CallWorkerListener( EventListenerTable::Listener& listener, const IEventDataPtr& pEvent ) {
+	bool wasInWorkerListener = t_inWorkerListener;  // the main thread helps out and may already be in one
+	t_inWorkerListener = true;
+	bool called = CallListener(listener, pEvent);
+	t_inWorkerListener = wasInWorkerListener;
+	return called;
+}//CallWorkerListener
 
 EventManager::EventManager( const std::string name, bool global )
-	: IEventManager(name, global)
+	: IEventManager(name, global),
+	  m_timerWheel(Clock::nowUs())
 {
-	m_activeQueue = 0;
+	m_hasSerializedJobs = false;
+	m_isDispatching = false;
+	m_statsPeriodNs = 0;
+	m_nextStatsDumpNs = 0;
+	m_pParent = NULL;
+	m_parentDelegate = fastdelegate::MakeDelegate(this, &EventManager::onParentEvent);
+
+	for( unsigned int i = 0; i < EVENT_NUM_PRIORITIES; ++i ) {
+		m_lanes[i].budgetMicros = IEventManager::kINFINITE;
+		m_lastUpdateReport.lanes[i] = EventLaneReport();
+	}
 }//EventManager::EventManager
 
 EventManager::~EventManager()
 {
+	setParent(NULL);
+
+	for( auto it = m_children.begin(); it != m_children.end(); ++it )
+		(*it)->m_pParent = NULL;
+	m_children.clear();
 }//EventManager::~EventManager
 
-bool EventManager::addListener( const EventListenerDelegate& eventDelegate, const EventType& type ) {
-	GEN_LOG("Events", "Attempting to add delegate function for event type: " + std::to_string(type));
-	EventListenerList& eventListenerList = m_eventListeners[type]; //this will find or create the entry
-	for( auto it = eventListenerList.begin(); it != eventListenerList.end(); ++it ) {
-		if( eventDelegate == (*it) ) {
-			GEN_WARNING("Attempting to double-register a delegate");
-			return false;
-		}
+//---------------------------------------------------------------------------------------------------------------------
+// The concurrency hint only affects queued events dispatched by update(); instantEvent() always calls every listener
+// inline on the calling thread.  Listeners can be added and removed from any thread, even while update() is running;
+// see EventListenerTable.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::addListener( const EventListenerDelegate& eventDelegate, const EventType& type, ListenerConcurrency concurrency ) {
+	unsigned int numListeners = 0;
+	if( !m_eventListeners.add(type, eventDelegate, concurrency, numListeners) ) {
+		GEN_WARNING("Attempting to double-register a delegate");
+		return false;
 	}
 
-	eventListenerList.push_back(eventDelegate);
-	GEN_LOG("Events", "Successfully added delegate for event type: " + std::to_string(type));
-
+	GEN_EVENT_TYPE_TRACE(g_eventsLogChannel, "addListener", type, numListeners);
 	return true;
 }//EventManager::addListener
 
 bool EventManager::removeListener( const EventListenerDelegate& eventDelegate, const EventType& type ) {
-	GEN_LOG("Events", "Attempting to remove delegate function from event type: " + std::to_string(type));
-	bool success = false;
-
-	auto findIt = m_eventListeners.find(type);
-	if( findIt != m_eventListeners.end() ) {
-		EventListenerList& listeners = findIt->second;
-		for( auto it = listeners.begin(); it != listeners.end(); ++it ) {
-			if( eventDelegate == (*it) ) {
-				listeners.erase(it);
-				GEN_LOG("Events", "Successfully removed delegate function from event type: " + std::to_string(type));
-				success = true;
-				break;
-			}
-		}
-	}
+	unsigned int numListeners = 0;
+	if( !m_eventListeners.remove(type, eventDelegate, numListeners) )
+		return false;
 
-	return success;
+	GEN_EVENT_TYPE_TRACE(g_eventsLogChannel, "removeListener", type, numListeners);
+	return true;
 }//EventManager::removeListener
 
-bool EventManager::instantEvent( const IEventDataPtr& pEvent ) const {
-	GEN_LOG("Events", "Attempting to trigger event " + std::string(pEvent->getName()));
-	bool processed = false;
-
-	auto findIt = m_eventListeners.find(pEvent->getEventType());
-	if( findIt != m_eventListeners.end() ) {
-		const EventListenerList& eventListenerList = findIt->second;
-		for( EventListenerList::const_iterator it = eventListenerList.begin(); it != eventListenerList.end(); ++it ) {
-			EventListenerDelegate listener = (*it);
-			GEN_LOG("Events", "Sending Event " + std::string(pEvent->getName()) + " to delegate.");
-			listener(pEvent);
-			processed = true;
+bool EventManager::instantEvent( const IEventDataPtr& pEvent ) {
+	unsigned long listenersCalled = 0;
+
+	// this may run on any thread, so it only reads the manager's state; the count lives in the listener table
+	EventListenerTable::ReadScope scope(m_eventListeners);
+	const EventListenerTable::Slot* pSlot = m_eventListeners.findSlot(pEvent->getEventType());
+	const EventListenerList* pListeners = pSlot ? pSlot->load() : NULL;
+	if( pListeners ) {
+		pSlot->instant.fetch_add(1, std::memory_order_relaxed);
+		for( auto it = pListeners->begin(); it != pListeners->end(); ++it ) {
+			if( CallListener(**it, pEvent) )
+				++listenersCalled;
 		}
 	}
 
-	return processed;
+	GEN_EVENT_TRACE(g_eventsLogChannel, "instant", pEvent.get(), listenersCalled);
+	return (listenersCalled > 0);
 }//EventManager::instantEvent
 
 bool EventManager::queueEvent( const IEventDataPtr& pEvent ) {
-	GEN_ASSERT(m_activeQueue >= 0);
-	GEN_ASSERT(m_activeQueue < EVENTMANAGER_NUM_QUEUES);
 	if( !pEvent ) {
 		GEN_ERROR("Invalid event in queueEvent()");
 		return false;
 	}
 
-	GEN_LOG("Events", "Attempting to queue event: " + std::string(pEvent->getName()));
+	// the queues aren't locked, so a worker listener has to go through the realtime queue
+	if( t_inWorkerListener ) {
+		GEN_ERROR("queueEvent() called from a worker listener; use queueEventThreadSafe()");
+		return queueEventThreadSafe(pEvent);
+	}
+
+	if( m_recorder.isRecording() )
+		m_recorder.record(*pEvent, m_isDispatching ? EVENT_RECORD_FROM_DISPATCH : 0);
+
+	bool routed = false;
+	if( m_pParent ) {
+		auto stateIt = m_typeStates.find(pEvent->getEventType());
+		if( stateIt != m_typeStates.end() && stateIt->second.routeToParent )
+			routed = m_pParent->queueEvent(pEvent);
+	}
+
+	return (queueLocalEvent(pEvent) || routed);
+}//EventManager::queueEvent
 
-	auto findIt = m_eventListeners.find(pEvent->getEventType());
-	if( findIt != m_eventListeners.end() ) {
-		m_queues[m_activeQueue].push_back(pEvent);
-		GEN_LOG("Events", "Successfully queued event: " + std::string(pEvent->getName()));
+//---------------------------------------------------------------------------------------------------------------------
+// Queues an event for this manager's own listeners.  It is dropped if there aren't any.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::queueLocalEvent( const IEventDataPtr& pEvent ) {
+	if( m_eventListeners.hasListeners(pEvent->getEventType()) ) {
+		EventTypeState& typeState = m_typeStates[pEvent->getEventType()];
+		if( typeState.name.empty() )
+			typeState.name = pEvent->getName();
+
+		EventQueue& queue = m_lanes[typeState.priority].queue;
+		if( coalesceEvent(pEvent, typeState) )
+			++typeState.coalesced;
+		else
+			queue.push(pEvent, &typeState.chain, Clock::nowNs());
+		GEN_EVENT_TRACE(g_eventsLogChannel, "queue", pEvent.get(), (unsigned long)queue.size());
 		return true;
 	}
 	else {
-		GEN_LOG("Events", "Skipping event since there are no delegates registered to receive it: " + std::string(pEvent->getName()));
+		GEN_EVENT_TRACE(g_eventsLogChannel, "skipNoListeners", pEvent.get(), 0);
 		return false;
 	}
-}//EventManager::queueEvent
+}//EventManager::queueLocalEvent
 
 bool EventManager::queueEventThreadSafe( const IEventDataPtr& pEvent ) {
 	if( !pEvent ) {
 		return false;
 	}
 
-	m_realtimeEventQueue.push(pEvent);
-
-	return true;
+	return m_realtimeEventQueue.push(pEvent);
 }//EventManager::queueEventThreadSafe
 
+//---------------------------------------------------------------------------------------------------------------------
+// Gives the calling thread its own bounded queue for queueEventThreadSafe().  Threads that never register get one with
+// the default capacity and overflow policy the first time they queue an event.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::registerRealtimeProducer( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy ) {
+	return m_realtimeEventQueue.registerProducer(name, capacity, policy);
+}//EventManager::registerRealtimeProducer
+
+void EventManager::unregisterRealtimeProducer() {
+	m_realtimeEventQueue.unregisterProducer();
+}//EventManager::unregisterRealtimeProducer
+
+//---------------------------------------------------------------------------------------------------------------------
+// Aborts the oldest queued event of the given type, or all of them.  Only the type's chain through the queue is
+// walked, so this costs time proportional to the number of events removed, not the size of the queue.  Events can't
+// be unlinked from the middle of the ring, so their slots are just emptied and update() skips them.
+//---------------------------------------------------------------------------------------------------------------------
 bool EventManager::abortEvent( const EventType& type, bool allOfType ) {
-	GEN_ASSERT(m_activeQueue >= 0);
-	GEN_ASSERT(m_activeQueue < EVENTMANAGER_NUM_QUEUES);
-
-	bool success = false;
-	EventListenerMap::iterator findIt = m_eventListeners.find(type);
-
-	if( findIt != m_eventListeners.end() ) {
-		EventQueue& eventQueue = m_queues[m_activeQueue];
-		auto it = eventQueue.begin();
-		while( it != eventQueue.end() ) {
-			auto thisIt = it;
-			++it;
-
-			if( (*thisIt)->getEventType() == type ) {
-				eventQueue.erase(thisIt);
-				success = true;
-				if( !allOfType )
-					break;
+	auto stateIt = m_typeStates.find(type);
+	if( stateIt == m_typeStates.end() )
+		return false;
+
+	EventQueue::TypeChain& chain = stateIt->second.chain;
+	EventQueue& queue = m_lanes[stateIt->second.priority].queue;
+	unsigned int numAborted = 0;
+	if( allOfType )
+		numAborted = queue.abortAll(chain);
+	else if( queue.abortFirst(chain) )
+		numAborted = 1;
+
+	GEN_EVENT_TYPE_TRACE(g_eventsLogChannel, "abort", type, numAborted);
+	return (numAborted > 0);
+}//EventManager::abortEvent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Sets how queued events of a type are coalesced.  The check happens in queueEvent() and is O(1): the newest queued
+// event of a type is the last one on its chain, so a burst of mouse moves collapses into one queue entry and one
+// dispatch.  Events coming in through queueEventThreadSafe() are coalesced when update() drains them.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::setCoalescePolicy( const EventType& type, EventCoalescePolicy policy, const EventMergeDelegate& merge ) {
+	if( policy == EVENT_COALESCE_MERGE && merge.empty() ) {
+		GEN_ERROR("EVENT_COALESCE_MERGE needs a merge delegate");
+		return false;
+	}
+
+	EventTypeState& typeState = m_typeStates[type];
+	typeState.coalescePolicy = policy;
+	typeState.merge = merge;
+
+	return true;
+}//EventManager::setCoalescePolicy
+
+//---------------------------------------------------------------------------------------------------------------------
+// Folds pEvent into the pending event of its type, if there is one.  Returns false if pEvent still needs to be queued.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::coalesceEvent( const IEventDataPtr& pEvent, EventTypeState& typeState ) {
+	if( typeState.coalescePolicy == EVENT_COALESCE_NONE || typeState.chain.count == 0 )
+		return false;
+
+	IEventDataPtr& pPending = m_lanes[typeState.priority].queue.at(typeState.chain.last).pEvent;
+
+	switch( typeState.coalescePolicy ) {
+		case EVENT_COALESCE_REPLACE :
+		{
+			pPending = pEvent;
+			break;
+		}
+
+		case EVENT_COALESCE_MERGE :
+		{
+			IEventDataPtr pMerged = typeState.merge(pPending, pEvent);
+			if( !pMerged )
+				return false;
+			pPending = pMerged;
+			break;
+		}
+
+		case EVENT_COALESCE_KEEP_FIRST :
+		default:
+		{
+			break;
+		}
+	}
+
+	GEN_EVENT_TRACE(g_eventsLogChannel, "coalesce", pEvent.get(), typeState.chain.count);
+	return true;
+}//EventManager::coalesceEvent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Moves an event type to a different priority lane.  A type's events all live in one lane, so this fails while any are
+// still queued.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::setEventPriority( const EventType& type, EventPriority priority ) {
+	if( priority >= EVENT_NUM_PRIORITIES ) {
+		GEN_ERROR("Invalid event priority");
+		return false;
+	}
+
+	EventTypeState& typeState = m_typeStates[type];
+	if( typeState.priority != priority && typeState.chain.count > 0 ) {
+		GEN_WARNING("Attempting to change the priority of an event type while events of that type are queued");
+		return false;
+	}
+
+	typeState.priority = priority;
+	return true;
+}//EventManager::setEventPriority
+
+//---------------------------------------------------------------------------------------------------------------------
+// Caps how long update() may spend on one lane.  Time a lane doesn't use is left for the lanes after it.
+//---------------------------------------------------------------------------------------------------------------------
+void EventManager::setLaneBudget( EventPriority lane, unsigned long maxMicros ) {
+	if( lane >= EVENT_NUM_PRIORITIES ) {
+		GEN_ERROR("Invalid event lane");
+		return;
+	}
+
+	m_lanes[lane].budgetMicros = maxMicros;
+}//EventManager::setLaneBudget
+
+EventTimerHandle EventManager::queueEventAt( const IEventDataPtr& pEvent, unsigned long long timeMicros ) {
+	if( !pEvent ) {
+		GEN_ERROR("Invalid event in queueEventAt()");
+		return 0;
+	}
+	return m_timerWheel.schedule(pEvent, timeMicros);
+}//EventManager::queueEventAt
+
+EventTimerHandle EventManager::queueEventAfter( const IEventDataPtr& pEvent, unsigned long delayMicros ) {
+	return queueEventAt(pEvent, Clock::nowUs() + delayMicros);
+}//EventManager::queueEventAfter
+
+bool EventManager::cancelTimedEvent( EventTimerHandle handle ) {
+	return m_timerWheel.cancel(handle);
+}//EventManager::cancelTimedEvent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Every event passed to queueEvent() is recorded, including the ones it drops for having no listeners, so a replay
+// makes the same calls whatever listeners are registered at the time.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::startRecording( const std::string& fileName ) {
+	return m_recorder.start(fileName);
+}//EventManager::startRecording
+
+void EventManager::stopRecording() {
+	m_recorder.stop();
+}//EventManager::stopRecording
+
+//---------------------------------------------------------------------------------------------------------------------
+// Moves this manager under pParent, taking its subscriptions along.  A manager can't be its own ancestor.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::setParent( EventManager* pParent ) {
+	for( EventManager* pAncestor = pParent; pAncestor; pAncestor = pAncestor->m_pParent ) {
+		if( pAncestor == this ) {
+			GEN_ERROR("Event manager routing would form a cycle");
+			return false;
+		}
+	}
+
+	if( m_pParent ) {
+		for( auto it = m_parentSubscriptions.begin(); it != m_parentSubscriptions.end(); ++it )
+			m_pParent->removeListener(m_parentDelegate, *it);
+
+		std::vector<EventManager*>& siblings = m_pParent->m_children;
+		for( auto it = siblings.begin(); it != siblings.end(); ++it ) {
+			if( *it == this ) {
+				siblings.erase(it);
+				break;
 			}
 		}
 	}
 
-	return success;
-}//EventManager::abortEvent
+	m_pParent = pParent;
+
+	if( m_pParent ) {
+		m_pParent->m_children.push_back(this);
+		for( auto it = m_parentSubscriptions.begin(); it != m_parentSubscriptions.end(); ++it )
+			m_pParent->addListener(m_parentDelegate, *it);
+	}
+
+	return true;
+}//EventManager::setParent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Events of the type queued on this manager are queued on the parent as well, where the rest of the game can listen
+// for them.  A type can't be both routed up and subscribed to from the parent, or it would come straight back down.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::routeToParent( const EventType& type, bool route ) {
+	if( route && std::find(m_parentSubscriptions.begin(), m_parentSubscriptions.end(), type) != m_parentSubscriptions.end() ) {
+		GEN_WARNING("Attempting to route an event type to the parent that is subscribed to from the parent");
+		return false;
+	}
+
+	m_typeStates[type].routeToParent = route;
+	return true;
+}//EventManager::routeToParent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Events of the type queued on the parent (or routed up to it by a sibling) are passed down and queued here.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::subscribeToParent( const EventType& type ) {
+	auto stateIt = m_typeStates.find(type);
+	if( stateIt != m_typeStates.end() && stateIt->second.routeToParent ) {
+		GEN_WARNING("Attempting to subscribe to an event type from the parent that is routed to the parent");
+		return false;
+	}
+
+	if( std::find(m_parentSubscriptions.begin(), m_parentSubscriptions.end(), type) != m_parentSubscriptions.end() )
+		return false;
+
+	m_parentSubscriptions.push_back(type);
+	if( m_pParent )
+		m_pParent->addListener(m_parentDelegate, type);
+	return true;
+}//EventManager::subscribeToParent
+
+bool EventManager::unsubscribeFromParent( const EventType& type ) {
+	auto findIt = std::find(m_parentSubscriptions.begin(), m_parentSubscriptions.end(), type);
+	if( findIt == m_parentSubscriptions.end() )
+		return false;
+
+	m_parentSubscriptions.erase(findIt);
+	if( m_pParent )
+		m_pParent->removeListener(m_parentDelegate, type);
+	return true;
+}//EventManager::unsubscribeFromParent
 
-bool EventManager::update( unsigned long maxMillis ) {
-	unsigned long currMs = GetTickCount();
-	unsigned long maxMs = ((maxMillis == IEventManager::kINFINITE) ? (IEventManager::kINFINITE) : (currMs + maxMillis));
+void EventManager::onParentEvent( const IEventDataPtr& pEvent ) {
+	queueLocalEvent(pEvent);
+}//EventManager::onParentEvent
 
-	// This section added to handle events from other threads.  Check out Chapter 20.
-	IEventDataPtr pRealtimeEvent;
-	while( m_realtimeEventQueue.try_pop(pRealtimeEvent) ) {
-		queueEvent(pRealtimeEvent);
+bool EventManager::update( unsigned long maxMicros ) {
+	const unsigned long long deadlineNs = DeadlineNs(Clock::nowNs(), maxMicros);
+
+	// Pull in events from other threads a chunk at a time.  Whatever doesn't fit in the budget stays in the producers'
+	// rings, where their overflow policies take care of a thread that's flooding us.
+	for( unsigned int round = 0; round < EVENTMANAGER_REALTIME_MAX_DRAIN_ROUNDS; ++round ) {
+		m_realtimeBatch.clear();
+		if( m_realtimeEventQueue.drain(m_realtimeBatch, EVENTMANAGER_REALTIME_DRAIN_CHUNK) == 0 )
+			break;
 
-		currMs = GetTickCount();
-		if( maxMillis != IEventManager::kINFINITE ) {
-			if( currMs >= maxMs ) {
-				GEN_ERROR("A realtime process is spamming the event manager!");
+		for( auto it = m_realtimeBatch.begin(); it != m_realtimeBatch.end(); ++it )
+			queueEvent(*it);
+
+		if( deadlineNs != EVENTMANAGER_NO_DEADLINE && Clock::nowNs() >= deadlineNs ) {
+			GEN_EVENT_TRACE(g_eventLoopLogChannel, "realtimeOutOfTime", NULL, round + 1);
+			break;
+		}
+	}
+	m_realtimeBatch.clear();
+
+	// timed events that came due join the back of their lanes like any other queued event
+	m_timerWheel.advance(Clock::nowUs(), m_expiredTimers);
+	for( auto it = m_expiredTimers.begin(); it != m_expiredTimers.end(); ++it )
+		queueEvent(*it);
+	m_expiredTimers.clear();
+
+	// Only process the events that are already queued.  Anything queued by a listener lands behind its lane's batch end
+	// and waits for the next update, which is what the old double-buffered queues gave us without the extra list.
+	EventQueue::Sequence batchEnds[EVENT_NUM_PRIORITIES];
+	for( unsigned int i = 0; i < EVENT_NUM_PRIORITIES; ++i )
+		batchEnds[i] = m_lanes[i].queue.tail();
+
+	// Process the lanes from highest to lowest priority.  The read scope keeps every listener list that dispatch picks up
+	// alive until the worker jobs are done, whatever other threads or the listeners themselves register meanwhile.
+	bool queueFlushed = true;
+	{
+		EventListenerTable::ReadScope scope(m_eventListeners);
+		m_isDispatching = true;
+		for( unsigned int i = 0; i < EVENT_NUM_PRIORITIES; ++i ) {
+			EventLane& lane = m_lanes[i];
+			EventLaneReport& report = m_lastUpdateReport.lanes[i];
+			report = EventLaneReport();
+
+			unsigned long long laneDeadlineNs = deadlineNs;
+			if( lane.budgetMicros != IEventManager::kINFINITE ) {
+				unsigned long long budgetEndNs = DeadlineNs(Clock::nowNs(), lane.budgetMicros);
+				if( budgetEndNs < laneDeadlineNs )
+					laneDeadlineNs = budgetEndNs;
 			}
+
+			// the critical lane always gets at least one event through, even if the realtime drain used up the budget
+			if( !processLane(lane, batchEnds[i], laneDeadlineNs, (i != EVENT_PRIORITY_CRITICAL), report) )
+				queueFlushed = false;
 		}
+
+		flushTypedEvents();
+
+		// hand the listeners that don't need the main thread to the worker pool
+		runWorkerJobs();
+		m_isDispatching = false;
 	}
+	m_eventListeners.reclaim();
 
-	// swap active queues and clear the new queue after the swap
-	int queueToProcess = m_activeQueue;
-	m_activeQueue = (m_activeQueue + 1) % EVENTMANAGER_NUM_QUEUES;
-	m_queues[m_activeQueue].clear();
+	if( m_statsPeriodNs > 0 ) {
+		unsigned long long nowNs = Clock::nowNs();
+		if( nowNs >= m_nextStatsDumpNs )
+			dumpStats(nowNs);
+	}
 
-	GEN_LOG("EventLoop", "Processing Event Queue " + std::to_string(queueToProcess) + "; " + std::to_string((unsigned long)m_queues[queueToProcess].size()) + " events to process");
+	m_recorder.nextFrame();
+	return queueFlushed;
+}//EventManager::update
 
-	// Process the queue
-	while( !m_queues[queueToProcess].empty() ) {
-		// pop the front of the queue
-		IEventDataPtr pEvent = m_queues[queueToProcess].front();
-		m_queues[queueToProcess].pop_front();
-		GEN_LOG("EventLoop", "\t\tProcessing Event " + std::string(pEvent->getName()));
+//---------------------------------------------------------------------------------------------------------------------
+// Dispatches a lane's events up to batchEnd or until deadlineNs.  Events that don't get dispatched simply stay at the
+// front of the lane's ring, ahead of anything queued since, so carrying them over to the next update costs nothing.
+// Returns true if the lane's batch was finished.
+//---------------------------------------------------------------------------------------------------------------------
+bool EventManager::processLane( EventLane& lane, EventQueue::Sequence batchEnd, unsigned long long deadlineNs, bool checkTimeFirst, EventLaneReport& report ) {
+	EventQueue& queue = lane.queue;
+	if( queue.head() == batchEnd )
+		return true;
+
+	GEN_EVENT_TRACE(g_eventLoopLogChannel, "batch", NULL, (unsigned long)(batchEnd - queue.head()));
 
+	unsigned long long currNs = Clock::nowNs();
+	if( checkTimeFirst && currNs >= deadlineNs ) {
+		report.deferred = (unsigned long)(batchEnd - queue.head());
+		return false;
+	}
+
+	// the clock is sampled every checkInterval events; latencies are measured against the last sample
+	unsigned int checkInterval = 1;
+	unsigned int eventsSinceCheck = 0;
+	unsigned long long lastCheckNs = currNs;
+
+	while( queue.head() != batchEnd ) {
+		// pop the front of the queue
+		unsigned long long queuedNs = queue.at(queue.head()).stamp;
+		IEventDataPtr pEvent = queue.pop();
+		if( !pEvent )
+			continue;  // aborted
 		const EventType& eventType = pEvent->getEventType();
 
-		// find all the delegate functions registered for this event
-		auto findIt = m_eventListeners.find(eventType);
-		if( findIt != m_eventListeners.end() ) {
-			const EventListenerList& eventListeners = findIt->second;
-			GEN_LOG("EventLoop", "\t\tFound " + std::to_string((unsigned long)eventListeners.size()) + " delegates");
+		unsigned long long latencyUs = (currNs > queuedNs) ? ((currNs - queuedNs) / 1000) : 0;
+		report.totalLatencyUs += latencyUs;
+		if( latencyUs > report.maxLatencyUs )
+			report.maxLatencyUs = latencyUs;
+		++report.dispatched;
 
+		// find all the delegate functions registered for this event
+		const EventListenerList* pListeners = m_eventListeners.find(eventType);
+		if( pListeners ) {
 			// call each listener
-			for( auto it = eventListeners.begin(); it != eventListeners.end(); ++it ) {
-				EventListenerDelegate listener = (*it);
-				GEN_LOG("EventLoop", "\t\tSending event " + std::string(pEvent->getName()) + " to delegate");
-				listener(pEvent);
-			}
+			dispatchEvent(pEvent, *pListeners);
+
+			GEN_EVENT_TRACE(g_eventLoopLogChannel, "dispatch", pEvent.get(), (unsigned long)pListeners->size());
 		}
 
 		// check to see if time ran out
-		currMs = GetTickCount();
-		if( maxMillis != IEventManager::kINFINITE && currMs >= maxMs ) {
-			GEN_LOG("EventLoop", "Aborting event processing; time ran out");
+		if( ++eventsSinceCheck < checkInterval )
+			continue;
+
+		currNs = Clock::nowNs();
+		if( currNs >= deadlineNs ) {
+			report.deferred = (unsigned long)(batchEnd - queue.head());
+			if( report.deferred > 0 )
+				GEN_EVENT_TRACE(g_eventLoopLogChannel, "outOfTime", NULL, report.deferred);
 			break;
 		}
+
+		// pick the next interval from the average cost of the events since the last check
+		unsigned long long nsPerEvent = (currNs - lastCheckNs) / eventsSinceCheck;
+		unsigned long long eventsLeftInBudget = (nsPerEvent > 0) ? ((deadlineNs - currNs) / nsPerEvent) : EVENTMANAGER_MAX_EVENTS_PER_TIME_CHECK;
+		checkInterval = (unsigned int)((eventsLeftInBudget / 4 < EVENTMANAGER_MAX_EVENTS_PER_TIME_CHECK) ? (eventsLeftInBudget / 4) : EVENTMANAGER_MAX_EVENTS_PER_TIME_CHECK);
+		if( checkInterval == 0 )
+			checkInterval = 1;
+		eventsSinceCheck = 0;
+		lastCheckNs = currNs;
+	}
+
+	return (queue.head() == batchEnd);
+}//EventManager::processLane
+
+void EventManager::getStats( EventStatsSnapshot& outSnapshot ) const {
+	outSnapshot.timeNs = Clock::nowNs();
+	outSnapshot.types.clear();
+	outSnapshot.listeners.clear();
+
+	std::unordered_map<EventType, size_t> typeIndices;
+	for( auto it = m_typeStates.begin(); it != m_typeStates.end(); ++it ) {
+		const EventTypeState& typeState = it->second;
+		EventTypeStats stats;
+		stats.type = it->first;
+		stats.name = typeState.name;
+		stats.priority = typeState.priority;
+		stats.queued = typeState.chain.pushed + typeState.coalesced;
+		stats.coalesced = typeState.coalesced;
+		stats.dispatched = typeState.chain.popped;
+		stats.aborted = typeState.chain.aborted;
+		stats.instant = 0;  // from the listener table below
+		stats.queueDepth = typeState.chain.count;
+		stats.maxQueueDepth = typeState.chain.maxCount;
+		stats.handlerNs = 0;
+
+		typeIndices[stats.type] = outSnapshot.types.size();
+		outSnapshot.types.push_back(stats);
 	}
 
-	// If we couldn't process all of the events, push the remaining events to the new active queue.
-	// Note: To preserve sequencing, go back-to-front, inserting them at the head of the active queue
-	bool queueFlushed = (m_queues[queueToProcess].empty());
-	if( !queueFlushed ) {
-		while( !m_queues[queueToProcess].empty() ) {
-			IEventDataPtr pEvent = m_queues[queueToProcess].back();
-			m_queues[queueToProcess].pop_back();
-			m_queues[m_activeQueue].push_front(pEvent);
+	EventListenerTable::ReadScope scope(m_eventListeners);
+	const EventListenerTable::TypeMap& listenerTypes = m_eventListeners.getTypes();
+	for( auto typeIt = listenerTypes.begin(); typeIt != listenerTypes.end(); ++typeIt ) {
+		// types that were only ever raised with instantEvent() have no state of their own
+		unsigned long long numInstant = typeIt->second->instant.load(std::memory_order_relaxed);
+		auto indexIt = typeIndices.find(typeIt->first);
+		if( indexIt == typeIndices.end() && numInstant > 0 ) {
+			EventTypeStats stats = EventTypeStats();
+			stats.type = typeIt->first;
+			stats.priority = EVENT_PRIORITY_NORMAL;
+			indexIt = typeIndices.insert(std::make_pair(stats.type, outSnapshot.types.size())).first;
+			outSnapshot.types.push_back(stats);
 		}
+		if( indexIt != typeIndices.end() )
+			outSnapshot.types[indexIt->second].instant = numInstant;
+
+		const EventListenerList* pListeners = typeIt->second->load();
+		if( !pListeners )
+			continue;
+
+		unsigned int index = 0;
+		for( auto it = pListeners->begin(); it != pListeners->end(); ++it, ++index ) {
+			const EventListenerCounters& counters = (*it)->counters;
+			EventListenerStats stats;
+			stats.type = typeIt->first;
+			stats.index = index;
+			stats.concurrency = (*it)->concurrency;
+			stats.calls = counters.calls.load(std::memory_order_relaxed);
+			stats.totalNs = counters.totalNs.load(std::memory_order_relaxed);
+			stats.maxNs = counters.maxNs.load(std::memory_order_relaxed);
+			outSnapshot.listeners.push_back(stats);
+
+			if( indexIt != typeIndices.end() )
+				outSnapshot.types[indexIt->second].handlerNs += stats.totalNs;
+		}
+	}
+}//EventManager::getStats
+
+//---------------------------------------------------------------------------------------------------------------------
+// Zeroes the running totals.  Queue depths are current state, so only the high water marks are reset.
+//---------------------------------------------------------------------------------------------------------------------
+void EventManager::resetStats() {
+	for( auto it = m_typeStates.begin(); it != m_typeStates.end(); ++it ) {
+		EventTypeState& typeState = it->second;
+		typeState.chain.maxCount = typeState.chain.count;
+		typeState.chain.pushed = 0;
+		typeState.chain.popped = 0;
+		typeState.chain.aborted = 0;
+		typeState.coalesced = 0;
 	}
 
-	return queueFlushed;
-}//EventManager::update
+	EventListenerTable::ReadScope scope(m_eventListeners);
+	const EventListenerTable::TypeMap& listenerTypes = m_eventListeners.getTypes();
+	for( auto typeIt = listenerTypes.begin(); typeIt != listenerTypes.end(); ++typeIt ) {
+		typeIt->second->instant.store(0, std::memory_order_relaxed);
+		const EventListenerList* pListeners = typeIt->second->load();
+		if( !pListeners )
+			continue;
+		for( auto it = pListeners->begin(); it != pListeners->end(); ++it )
+			(*it)->counters.reset();
+	}
+}//EventManager::resetStats
+
+//---------------------------------------------------------------------------------------------------------------------
+// Appends a snapshot to fileName every periodMicros, checked at the end of each update().
+//---------------------------------------------------------------------------------------------------------------------
+void EventManager::setStatsDump( const std::string& fileName, unsigned long periodMicros ) {
+	m_statsFileName = fileName;
+	m_statsPeriodNs = (fileName.empty() || periodMicros == 0) ? 0 : ((unsigned long long)periodMicros * 1000);
+	m_nextStatsDumpNs = Clock::nowNs() + m_statsPeriodNs;
+}//EventManager::setStatsDump
+
+void EventManager::dumpStats( unsigned long long nowNs ) {
+	m_nextStatsDumpNs = nowNs + m_statsPeriodNs;
+
+	FILE* pFile = fopen(m_statsFileName.c_str(), "a");
+	if( !pFile ) {
+		GEN_WARNING("Unable to open the event stats file; dumping is turned off");
+		m_statsPeriodNs = 0;
+		return;
+	}
+
+	getStats(m_statsSnapshot);
+	fprintf(pFile, "# event stats at %llu ms\n", m_statsSnapshot.timeNs / 1000000);
+	fprintf(pFile, "# type name priority queued coalesced dispatched aborted instant depth maxDepth handlerUs\n");
+	for( auto it = m_statsSnapshot.types.begin(); it != m_statsSnapshot.types.end(); ++it ) {
+		fprintf(pFile, "type 0x%08lx %s %d %llu %llu %llu %llu %llu %u %u %llu\n", (unsigned long)it->type,
+			it->name.empty() ? "-" : it->name.c_str(), (int)it->priority, it->queued, it->coalesced, it->dispatched,
+			it->aborted, it->instant, it->queueDepth, it->maxQueueDepth, it->handlerNs / 1000);
+	}
+	fprintf(pFile, "# listener type index concurrency calls totalUs maxUs\n");
+	for( auto it = m_statsSnapshot.listeners.begin(); it != m_statsSnapshot.listeners.end(); ++it ) {
+		fprintf(pFile, "listener 0x%08lx %u %d %llu %llu %llu\n", (unsigned long)it->type, it->index, (int)it->concurrency,
+			it->calls, it->totalNs / 1000, it->maxNs / 1000);
+	}
+
+	fclose(pFile);
+}//EventManager::dumpStats
+
+//---------------------------------------------------------------------------------------------------------------------
+// Dispatches the typed events emitted before this update.  Only channels that have something pending are visited, and
+// each costs a single virtual call no matter how many events it holds.  Events emitted by the handlers are dispatched
+// in the next update at the latest.
+//---------------------------------------------------------------------------------------------------------------------
+void EventManager::flushTypedEvents() {
+	if( m_pendingTypedChannels.empty() )
+		return;
+
+	m_flushingTypedChannels.swap(m_pendingTypedChannels);
+	for( auto it = m_flushingTypedChannels.begin(); it != m_flushingTypedChannels.end(); ++it ) {
+		unsigned int numDispatched = m_typedChannels[*it]->flush();
+		GEN_EVENT_TRACE(g_eventLoopLogChannel, "typedFlush", NULL, numDispatched);
+	}
+	m_flushingTypedChannels.clear();
+}//EventManager::flushTypedEvents
+
+//---------------------------------------------------------------------------------------------------------------------
+// Calls the main thread listeners for an event right away and records a job for each of the others.  The jobs are run
+// by runWorkerJobs() at the end of the update.
+//---------------------------------------------------------------------------------------------------------------------
+void EventManager::dispatchEvent( const IEventDataPtr& pEvent, const EventListenerList& eventListeners ) {
+	size_t eventIndex = m_dispatchedEvents.size();
+	bool retained = false;
+
+	for( auto it = eventListeners.begin(); it != eventListeners.end(); ++it ) {
+		EventListener& listener = **it;
+		if( listener.concurrency == LISTENER_MAIN_THREAD ) {
+			CallListener(listener, pEvent);
+			continue;
+		}
+
+		if( !retained ) {
+			m_dispatchedEvents.push_back(pEvent);
+			retained = true;
+		}
+
+		ListenerJob job;
+		job.eventIndex = eventIndex;
+		job.pListener = &listener;
+		if( listener.concurrency == LISTENER_ANY_THREAD ) {
+			m_anyThreadJobs.push_back(job);
+		}
+		else {
+			m_serializedJobs[pEvent->getEventType()].push_back(job);
+			m_hasSerializedJobs = true;
+		}
+	}
+}//EventManager::dispatchEvent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runs the deferred listener calls on the TBB work-stealing pool and waits for them.  Each event type with serialized
+// listeners becomes one task that walks its jobs in queue order; any-thread jobs are split up with parallel_for, with
+// this thread helping out.
+//---------------------------------------------------------------------------------------------------------------------
+void EventManager::runWorkerJobs() {
+	if( m_dispatchedEvents.empty() )
+		return;
+
+	const std::vector<IEventDataPtr>& events = m_dispatchedEvents;
+	tbb::task_group serializedTasks;
+
+	if( m_hasSerializedJobs ) {
+		for( auto it = m_serializedJobs.begin(); it != m_serializedJobs.end(); ++it ) {
+			const ListenerJobList& jobs = it->second;
+			if( jobs.empty() )
+				continue;
+
+			serializedTasks.run([&events, &jobs]() {
+				for( auto jobIt = jobs.begin(); jobIt != jobs.end(); ++jobIt )
+					CallWorkerListener(*jobIt->pListener, events[jobIt->eventIndex]);
+			});
+		}
+	}
+
+	if( !m_anyThreadJobs.empty() ) {
+		const ListenerJobList& jobs = m_anyThreadJobs;
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, jobs.size()), [&events, &jobs]( const tbb::blocked_range<size_t>& range ) {
+			for( size_t i = range.begin(); i != range.end(); ++i )
+				CallWorkerListener(*jobs[i].pListener, events[jobs[i].eventIndex]);
+		});
+	}
+
+	serializedTasks.wait();
+
+	// keep the capacity around for the next update
+	for( auto it = m_serializedJobs.begin(); it != m_serializedJobs.end(); ++it )
+		it->second.clear();
+	m_hasSerializedJobs = false;
+	m_anyThreadJobs.clear();
+	m_dispatchedEvents.clear();
+}//EventManager::runWorkerJobs
 
 }
@@ -1,39 +1,230 @@
 #ifndef EVENT_MANAGER_IMP_H
 #define EVENT_MANAGER_IMP_H
 
-#include <list>
-#include <map>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "EventManager.h"
+#include "EventListenerTable.h"
+#include "EventQueue.h"
+#include "EventRecorder.h"
+#include "EventTimerWheel.h"
+#include "RealtimeEventQueue.h"
+#include "TypedEventChannel.h"
 
 namespace genesis {
 
-const unsigned int EVENTMANAGER_NUM_QUEUES = 2;
+// Realtime events are drained from each producer in chunks so the time budget can be checked between them.  A producer
+// can get at most EVENTMANAGER_REALTIME_DRAIN_CHUNK * EVENTMANAGER_REALTIME_MAX_DRAIN_ROUNDS events in per update;
+// anything beyond that stays in its ring and is subject to its overflow policy.
+const unsigned int EVENTMANAGER_REALTIME_DRAIN_CHUNK = 64;
+const unsigned int EVENTMANAGER_REALTIME_MAX_DRAIN_ROUNDS = 16;
+
+// Reading the clock after every event costs more than a cheap listener, so update() only checks its budget every few
+// events.  The interval adapts to how expensive the events have been so far, aiming to check again after a quarter of
+// the remaining budget, but never goes above EVENTMANAGER_MAX_EVENTS_PER_TIME_CHECK.
+const unsigned int EVENTMANAGER_MAX_EVENTS_PER_TIME_CHECK = 64;
+
+struct EventLaneReport {
+	unsigned long		dispatched;  // events dispatched from the lane
+	unsigned long		deferred;  // queue entries that were due but left for the next update because time ran out
+	unsigned long long	totalLatencyUs;  // sum over the dispatched events of the time they spent queued
+	unsigned long long	maxLatencyUs;
+};
+
+// What the last call to update() did, one report per priority lane
+struct EventUpdateReport {
+	EventLaneReport		lanes[EVENT_NUM_PRIORITIES];
+};
+
+// Totals for one event type since the stats were last reset
+struct EventTypeStats {
+	EventType			type;
+	std::string			name;  // getName() of the first event of the type that was queued
+	EventPriority		priority;
+	unsigned long long	queued;  // calls to queueEvent() that reached this manager's listeners
+	unsigned long long	coalesced;  // of those, how many were folded into a pending event
+	unsigned long long	dispatched;
+	unsigned long long	aborted;
+	unsigned long long	instant;  // instantEvent() calls
+	unsigned int		queueDepth;  // events pending right now
+	unsigned int		maxQueueDepth;
+	unsigned long long	handlerNs;  // time spent in all of the type's listeners
+};
+
+// Totals for one listener; index is the listener's position in its type's list when the snapshot was taken
+struct EventListenerStats {
+	EventType			type;
+	unsigned int		index;
+	ListenerConcurrency	concurrency;
+	unsigned long long	calls;
+	unsigned long long	totalNs;
+	unsigned long long	maxNs;
+};
+
+struct EventStatsSnapshot {
+	unsigned long long					timeNs;  // Clock::nowNs() when the snapshot was taken
+	std::vector<EventTypeStats>			types;
+	std::vector<EventListenerStats>		listeners;
+};
 
 class EventManager : public IEventManager {
 protected:
-	typedef std::list<EventListenerDelegate> EventListenerList;
-	typedef std::map<EventType, EventListenerList> EventListenerMap;
-	typedef std::list<IEventDataPtr> EventQueue;
+	typedef EventListenerTable::Listener EventListener;
+	typedef EventListenerTable::ListenerList EventListenerList;
+
+	// a listener call deferred to the worker pool; the event lives in m_dispatchedEvents and the listener is kept alive
+	// by update()'s read scope on the listener table for the rest of the update
+	struct ListenerJob {
+		size_t					eventIndex;
+		EventListener*			pListener;
+	};
+
+	// queue bookkeeping for one event type; entries are never erased, because queued events point at their chain
+	struct EventTypeState {
+		EventQueue::TypeChain	chain;  // every queued event of this type, all in the lane for priority
+		EventPriority			priority;
+		EventCoalescePolicy		coalescePolicy;
+		EventMergeDelegate		merge;
+		bool					routeToParent;  // queueEvent() also queues events of this type on the parent manager
+
+		// instrumentation; the chain keeps the push/pop/abort totals
+		std::string				name;
+		unsigned long long		coalesced;
+
+		EventTypeState() : priority(EVENT_PRIORITY_NORMAL), coalescePolicy(EVENT_COALESCE_NONE), routeToParent(false), coalesced(0) {}
+	};
+
+	struct EventLane {
+		EventQueue				queue;  // events queued during an update() wait behind the end of that update's batch
+		unsigned long			budgetMicros;  // kINFINITE means the lane may use whatever is left of update()'s budget
+	};
 
-	EventListenerMap		m_eventListeners;
-	EventQueue				m_queues[EVENTMANAGER_NUM_QUEUES];
-	int						m_activeQueue;
-	ThreadSafeEventQueue	m_realtimeEventQueue;
+	typedef std::vector<ListenerJob> ListenerJobList;
+	typedef std::unordered_map<EventType, ListenerJobList> SerializedJobMap;
+	typedef std::unordered_map<EventType, EventTypeState> EventTypeStateMap;
+
+	EventListenerTable		m_eventListeners;
+	EventLane				m_lanes[EVENT_NUM_PRIORITIES];
+	EventUpdateReport		m_lastUpdateReport;
+	EventTypeStateMap		m_typeStates;  // one entry for each type that has ever been queued or given a policy
+	RealtimeEventQueue		m_realtimeEventQueue;
+	std::vector<IEventDataPtr>	m_realtimeBatch;  // reused every update to drain m_realtimeEventQueue
+	EventRecorder			m_recorder;
+	EventTimerWheel			m_timerWheel;
+	std::vector<IEventDataPtr>	m_expiredTimers;  // reused every update to take the events off m_timerWheel
+	bool					m_isDispatching;  // update() is calling listeners; tags what they queue in recordings
+
+	// routing between a subsystem's manager and its parent
+	EventManager*			m_pParent;
+	std::vector<EventManager*>	m_children;
+	std::vector<EventType>	m_parentSubscriptions;  // types the parent passes down to this manager
+	EventListenerDelegate	m_parentDelegate;
+
+	// typed events, indexed by TypedEventIndex<TEvent>
+	std::vector<std::unique_ptr<ITypedEventChannel>>	m_typedChannels;
+	std::vector<unsigned int>	m_pendingTypedChannels;  // channels with events waiting for update()
+	std::vector<unsigned int>	m_flushingTypedChannels;
+
+	// periodic stats dump
+	std::string				m_statsFileName;
+	unsigned long long		m_statsPeriodNs;
+	unsigned long long		m_nextStatsDumpNs;
+	EventStatsSnapshot		m_statsSnapshot;  // reused by each dump
+
+	// listener calls that update() hands to the worker pool; all of these are reused from update to update
+	std::vector<IEventDataPtr>	m_dispatchedEvents;
+	ListenerJobList			m_anyThreadJobs;
+	SerializedJobMap		m_serializedJobs;
+	bool					m_hasSerializedJobs;
 
 public:
 	explicit EventManager( const std::string name, bool global );
 	virtual ~EventManager();
 
-	virtual bool addListener( const EventListenerDelegate& eventDelegate, const EventType& type );
+	virtual bool addListener( const EventListenerDelegate& eventDelegate, const EventType& type, ListenerConcurrency concurrency = LISTENER_MAIN_THREAD );
 	virtual bool removeListener( const EventListenerDelegate& eventDelegate, const EventType& type );
 
-	virtual bool instantEvent( const IEventDataPtr& event ) const;
+	virtual bool instantEvent( const IEventDataPtr& event );
 	virtual bool queueEvent( const IEventDataPtr& event );
 	virtual bool queueEventThreadSafe( const IEventDataPtr& event );
+	virtual EventTimerHandle queueEventAt( const IEventDataPtr& event, unsigned long long timeMicros );
+	virtual EventTimerHandle queueEventAfter( const IEventDataPtr& event, unsigned long delayMicros );
+	virtual bool cancelTimedEvent( EventTimerHandle handle );
+	virtual bool registerRealtimeProducer( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy );
+	virtual void unregisterRealtimeProducer();
 	virtual bool abortEvent( const EventType& type, bool allOfType = false );
+	virtual bool setCoalescePolicy( const EventType& type, EventCoalescePolicy policy, const EventMergeDelegate& merge = EventMergeDelegate() );
+	virtual bool setEventPriority( const EventType& type, EventPriority priority );
+	virtual void setLaneBudget( EventPriority lane, unsigned long maxMicros );
+
+	virtual bool startRecording( const std::string& fileName );
+	virtual void stopRecording();
+
+	virtual bool update( unsigned long maxMicros = kINFINITE );
+
+	// Sub-managers let a subsystem keep its listeners in a table of its own.  Only the types it routes up are seen by
+	// the parent, and only the types it subscribes to come down from the parent.
+	bool setParent( EventManager* pParent );  // NULL detaches
+	EventManager* getParent() const { return m_pParent; }
+	bool routeToParent( const EventType& type, bool route = true );
+	bool subscribeToParent( const EventType& type );
+	bool unsubscribeFromParent( const EventType& type );
+
+	// Typed events are plain classes that don't need to derive from IEventData.  subscribe() takes any callable that
+	// accepts a const TEvent&; emit() constructs the event in place in its type's storage.  The pending events of each
+	// type are dispatched by update() after the queued events, in the order they were emitted.  As with queueEvent(),
+	// an event nobody is subscribed to is dropped.  Both must be called from the thread that runs update().
+	template <class TEvent, class TCallable>
+	TypedSubscription subscribe( TCallable&& callable ) {
+		return getTypedChannel<TEvent>().subscribe(typename TypedEventChannel<TEvent>::Handler(std::forward<TCallable>(callable)));
+	}
+
+	template <class TEvent>
+	bool unsubscribe( TypedSubscription id ) {
+		return getTypedChannel<TEvent>().unsubscribe(id);
+	}
+
+	template <class TEvent, class... Args>
+	bool emit( Args&&... args ) {
+		TypedEventChannel<TEvent>& channel = getTypedChannel<TEvent>();
+		if( !channel.hasSubscribers() )
+			return false;
+		if( channel.emit(std::forward<Args>(args)...) )
+			m_pendingTypedChannels.push_back(TypedEventIndex<TEvent>::get());
+		return true;
+	}
+
+	// Per type and per listener counters are always on.  Taking a snapshot walks every type and listener, so it's meant
+	// for tools and periodic dumps, not every frame.
+	void getStats( EventStatsSnapshot& outSnapshot ) const;
+	void resetStats();
+	void setStatsDump( const std::string& fileName, unsigned long periodMicros );  // an empty name turns dumping off
+
+	void getRealtimeProducerStats( std::vector<RealtimeProducerStats>& outStats ) { m_realtimeEventQueue.getStats(outStats); }
+	const EventUpdateReport& getLastUpdateReport() const { return m_lastUpdateReport; }
+
+protected:
+	template <class TEvent>
+	TypedEventChannel<TEvent>& getTypedChannel() {
+		unsigned int index = TypedEventIndex<TEvent>::get();
+		if( index >= m_typedChannels.size() )
+			m_typedChannels.resize(index + 1);
+		if( !m_typedChannels[index] )
+			m_typedChannels[index].reset(new TypedEventChannel<TEvent>());
+		return static_cast<TypedEventChannel<TEvent>&>(*m_typedChannels[index]);
+	}
 
-	virtual bool update( unsigned long maxMillis = kINFINITE );
+	void flushTypedEvents();
+	void dumpStats( unsigned long long nowNs );
+	bool queueLocalEvent( const IEventDataPtr& pEvent );
+	void onParentEvent( const IEventDataPtr& pEvent );
+	bool coalesceEvent( const IEventDataPtr& pEvent, EventTypeState& typeState );
+	bool processLane( EventLane& lane, EventQueue::Sequence batchEnd, unsigned long long deadlineNs, bool checkTimeFirst, EventLaneReport& report );
+	void dispatchEvent( const IEventDataPtr& pEvent, const EventListenerList& eventListeners );
+	void runWorkerJobs();
 };
 
 }
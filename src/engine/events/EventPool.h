@@ -0,0 +1,42 @@
+#ifndef EVENT_POOL_H
+#define EVENT_POOL_H
+
+#include <memory>
+#include <utility>
+
+#include "EventManager.h"
+#include "utilities/memorypool.h"
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventPool class
+//
+// One MemoryPool per event class.  Each block holds a shared_ptr control block together with the event itself, so
+// an event created through MakeEvent() costs a free-list pop instead of a malloc.  The pool is intentionally never
+// destroyed: events may still be alive in listeners or queues during static destruction.
+//---------------------------------------------------------------------------------------------------------------------
+template <class TEvent>
+class EventPool {
+public:
+	// room for the event plus the shared_ptr bookkeeping (vtable, use/weak counts and the allocator)
+	static const size_t kBLOCK_SIZE = sizeof(TEvent) + (4 * sizeof(void*));
+
+	static MemoryPool& get() {
+		static MemoryPool* s_pPool = new MemoryPool(kBLOCK_SIZE);
+		return *s_pPool;
+	}
+
+	static bool reserve( unsigned int numEvents ) { return get().reserve(numEvents); }
+};
+
+// Creates an event whose storage comes from the pool for its class.  Use this instead of new/make_shared for any event
+// that is queued at a high rate.
+template <class TEvent, class... Args>
+inline std::shared_ptr<TEvent> MakeEvent( Args&&... args ) {
+	return std::allocate_shared<TEvent>(PoolAllocator<TEvent>(&EventPool<TEvent>::get()), std::forward<Args>(args)...);
+}//MakeEvent
+
+}
+
+#endif /* EVENT_POOL_H */
@@ -0,0 +1,119 @@
+#include <utility>
+
+#include "EventQueue.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+static size_t NextPowerOfTwo( size_t value ) {
+	size_t result = 1;
+	while( result < value )
+		result <<= 1;
+	return result;
+}//NextPowerOfTwo
+
+EventQueue::EventQueue( size_t initialCapacity ) {
+	m_slots.resize(NextPowerOfTwo(initialCapacity > 0 ? initialCapacity : 1));
+	m_mask = m_slots.size() - 1;
+	m_head = 0;
+	m_tail = 0;
+}//EventQueue::EventQueue
+
+EventQueue::Sequence EventQueue::push( const IEventDataPtr& pEvent, TypeChain* pChain, unsigned long long stamp ) {
+	if( size() == m_slots.size() )
+		grow(m_slots.size() * 2);
+
+	Sequence seq = m_tail++;
+	Slot& slot = at(seq);
+	slot.pEvent = pEvent;
+	slot.pChain = pChain;
+	slot.stamp = stamp;
+
+	if( pChain ) {
+		if( pChain->count > 0 )
+			at(pChain->last).nextOfType = seq;
+		else
+			pChain->first = seq;
+		pChain->last = seq;
+		++pChain->count;
+		++pChain->pushed;
+		if( pChain->count > pChain->maxCount )
+			pChain->maxCount = pChain->count;
+	}
+
+	return seq;
+}//EventQueue::push
+
+//---------------------------------------------------------------------------------------------------------------------
+// The queue is FIFO, so a live event at the front is always the oldest event on its chain.
+//---------------------------------------------------------------------------------------------------------------------
+IEventDataPtr EventQueue::pop() {
+	GEN_ASSERT(!empty());
+	Slot& slot = at(m_head);
+	if( slot.pChain ) {
+		GEN_ASSERT(slot.pChain->first == m_head);
+		slot.pChain->first = slot.nextOfType;
+		--slot.pChain->count;
+		++slot.pChain->popped;
+		slot.pChain = NULL;
+	}
+
+	IEventDataPtr pEvent(std::move(slot.pEvent));
+	++m_head;
+	return pEvent;
+}//EventQueue::pop
+
+bool EventQueue::abortFirst( TypeChain& chain ) {
+	if( chain.count == 0 )
+		return false;
+
+	Slot& slot = at(chain.first);
+	slot.pEvent.reset();
+	slot.pChain = NULL;
+	chain.first = slot.nextOfType;
+	--chain.count;
+	++chain.aborted;
+
+	return true;
+}//EventQueue::abortFirst
+
+unsigned int EventQueue::abortAll( TypeChain& chain ) {
+	unsigned int numAborted = chain.count;
+	Sequence seq = chain.first;
+	for( unsigned int i = 0; i < numAborted; ++i ) {
+		Slot& slot = at(seq);
+		slot.pEvent.reset();
+		slot.pChain = NULL;
+		seq = slot.nextOfType;
+	}
+	chain.count = 0;
+	chain.aborted += numAborted;
+
+	return numAborted;
+}//EventQueue::abortAll
+
+void EventQueue::clear() {
+	while( !empty() )
+		pop();
+}//EventQueue::clear
+
+void EventQueue::reserve( size_t capacity ) {
+	if( capacity > m_slots.size() )
+		grow(capacity);
+}//EventQueue::reserve
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reallocates the ring.  Sequence numbers are preserved; each live slot simply moves to its position under the new
+// mask.
+//---------------------------------------------------------------------------------------------------------------------
+void EventQueue::grow( size_t minCapacity ) {
+	std::vector<Slot> newSlots(NextPowerOfTwo(minCapacity));
+	size_t newMask = newSlots.size() - 1;
+	for( Sequence seq = m_head; seq != m_tail; ++seq )
+		newSlots[seq & newMask] = std::move(at(seq));
+
+	m_slots.swap(newSlots);
+	m_mask = newMask;
+}//EventQueue::grow
+
+}
@@ -0,0 +1,82 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <vector>
+
+#include "EventManager.h"
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventQueue class
+//
+// A growable ring buffer of events.  Every event pushed onto the queue is given a sequence number that stays valid
+// until it is popped, which lets the event manager address queued events directly (e.g. to coalesce into one in
+// place).  Slots are reused from frame to frame, so once the ring has grown to the peak queue depth, pushing and popping
+// never allocate.
+//
+// Events can also be threaded onto a TypeChain, an intrusive singly linked list through the ring of all the queued
+// events of one type.  Aborting events of a type walks the chain instead of the queue, so it costs time proportional
+// to the number of events removed.  Aborted events leave an empty slot (a tombstone) behind which is skipped when it
+// reaches the front.
+//---------------------------------------------------------------------------------------------------------------------
+class EventQueue {
+public:
+	typedef unsigned long long Sequence;
+
+	struct TypeChain {
+		Sequence		first;  // oldest queued event of the type
+		Sequence		last;  // newest queued event of the type
+		unsigned int	count;  // only first/last are meaningful when count > 0
+
+		// running totals for instrumentation; cheap enough to keep all the time
+		unsigned int		maxCount;
+		unsigned long long	pushed;
+		unsigned long long	popped;  // live events only; tombstones count as aborted
+		unsigned long long	aborted;
+
+		TypeChain() : first(0), last(0), count(0), maxCount(0), pushed(0), popped(0), aborted(0) {}
+	};
+
+	struct Slot {
+		IEventDataPtr	pEvent;  // NULL if the event was aborted
+		TypeChain*		pChain;  // the chain this event is on, if any
+		Sequence		nextOfType;  // next event on the same chain; valid if this isn't pChain->last
+		unsigned long long	stamp;  // when the event was queued, in whatever time units the owner uses
+
+		Slot() : pChain(NULL), nextOfType(0), stamp(0) {}
+	};
+
+private:
+	std::vector<Slot>	m_slots;
+	size_t				m_mask;  // m_slots.size() - 1; the size is always a power of two
+	Sequence			m_head;  // sequence number of the front of the queue
+	Sequence			m_tail;  // sequence number the next pushed event will get
+
+public:
+	explicit EventQueue( size_t initialCapacity = 256 );
+
+	Sequence push( const IEventDataPtr& pEvent, TypeChain* pChain = NULL, unsigned long long stamp = 0 );
+	IEventDataPtr pop();  // moves the front event out of the queue; may return NULL for an aborted event
+	bool abortFirst( TypeChain& chain );  // aborts the oldest event on the chain
+	unsigned int abortAll( TypeChain& chain );  // aborts every event on the chain and returns how many there were
+	void clear();
+	void reserve( size_t capacity );
+
+	Slot& at( Sequence seq ) { return m_slots[seq & m_mask]; }
+	const Slot& at( Sequence seq ) const { return m_slots[seq & m_mask]; }
+	bool contains( Sequence seq ) const { return (seq >= m_head && seq < m_tail); }
+
+	Sequence head() const { return m_head; }
+	Sequence tail() const { return m_tail; }
+	size_t size() const { return (size_t)(m_tail - m_head); }
+	bool empty() const { return m_head == m_tail; }
+	size_t capacity() const { return m_slots.size(); }
+
+private:
+	void grow( size_t minCapacity );
+};
+
+}
+
+#endif /* EVENT_QUEUE_H */
@@ -0,0 +1,215 @@
+#include "EventRecorder.h"
+#include "EventSerializer.h"
+#include "utilities/clock.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+static const char s_recordingMagic[4] = { 'G', 'E', 'V', 'R' };
+
+struct EventRecordingHeader {
+	char				magic[4];
+	unsigned short		formatVersion;
+	unsigned short		reserved;
+};
+
+EventRecorder::EventRecorder() {
+	m_pFile = NULL;
+	m_bufferUsed = 0;
+	m_frame = 0;
+	m_startNs = 0;
+	m_numRecorded = 0;
+	m_numSkipped = 0;
+}//EventRecorder::EventRecorder
+
+EventRecorder::~EventRecorder() {
+	stop();
+}//EventRecorder::~EventRecorder
+
+bool EventRecorder::start( const std::string& fileName ) {
+	if( isRecording() ) {
+		GEN_WARNING("Already recording events; stopping the old recording");
+		stop();
+	}
+
+	m_pFile = fopen(fileName.c_str(), "wb");
+	if( !m_pFile ) {
+		GEN_ERROR("Unable to open event recording file");
+		return false;
+	}
+
+	EventRecordingHeader header;
+	memcpy(header.magic, s_recordingMagic, sizeof(header.magic));
+	header.formatVersion = EVENTRECORDER_FORMAT_VERSION;
+	header.reserved = 0;
+	fwrite(&header, sizeof(header), 1, m_pFile);
+
+	m_buffer.resize(EVENTRECORDER_BUFFER_SIZE);
+	m_bufferUsed = 0;
+	m_frame = 0;
+	m_startNs = Clock::nowNs();
+	m_numRecorded = 0;
+	m_numSkipped = 0;
+
+	return true;
+}//EventRecorder::start
+
+void EventRecorder::stop() {
+	if( !m_pFile )
+		return;
+
+	flush();
+	fclose(m_pFile);
+	m_pFile = NULL;
+
+	if( m_numSkipped > 0 )
+		GEN_WARNING("Some events could not be serialized and are missing from the recording");
+}//EventRecorder::stop
+
+void EventRecorder::record( const IEventData& event, unsigned short flags ) {
+	if( !m_pFile )
+		return;
+
+	EventRecordEntry entry;
+	entry.frame = m_frame;
+	entry.flags = flags;
+	entry.reserved = 0;
+	entry.timeNs = Clock::nowNs() - m_startNs;
+
+	// serialize straight into the free end of the buffer, flushing and trying once more if it doesn't fit
+	for( int attempt = 0; attempt < 2; ++attempt ) {
+		EventWriter out(m_buffer.data() + m_bufferUsed, m_buffer.size() - m_bufferUsed);
+		if( out.writeBytes(&entry, sizeof(entry)) && WriteEvent(event, out) ) {
+			m_bufferUsed += out.size();
+			++m_numRecorded;
+			return;
+		}
+
+		if( !out.isOverflowed() || m_bufferUsed == 0 )
+			break;
+		flush();
+	}
+
+	++m_numSkipped;
+}//EventRecorder::record
+
+void EventRecorder::flush() {
+	if( m_bufferUsed > 0 ) {
+		if( fwrite(&m_buffer[0], 1, m_bufferUsed, m_pFile) != m_bufferUsed )
+			GEN_ERROR("Unable to write to the event recording file");
+		m_bufferUsed = 0;
+	}
+}//EventRecorder::flush
+
+
+EventReplayer::EventReplayer( const EventFactory& factory )
+	: m_factory(factory)
+{
+	m_pos = 0;
+	m_frame = 0;
+	m_replayFromDispatch = false;
+	m_numReplayed = 0;
+	m_numSkipped = 0;
+}//EventReplayer::EventReplayer
+
+bool EventReplayer::open( const std::string& fileName ) {
+	close();
+
+	FILE* pFile = fopen(fileName.c_str(), "rb");
+	if( !pFile ) {
+		GEN_ERROR("Unable to open event recording file");
+		return false;
+	}
+
+	fseek(pFile, 0, SEEK_END);
+	long fileSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	EventRecordingHeader header;
+	if( fileSize < (long)sizeof(header) || fread(&header, sizeof(header), 1, pFile) != 1 ||
+		memcmp(header.magic, s_recordingMagic, sizeof(header.magic)) != 0 || header.formatVersion != EVENTRECORDER_FORMAT_VERSION ) {
+		GEN_ERROR("Not an event recording, or one from an incompatible version");
+		fclose(pFile);
+		return false;
+	}
+
+	m_data.resize(fileSize - sizeof(header));
+	if( !m_data.empty() && fread(&m_data[0], 1, m_data.size(), pFile) != m_data.size() ) {
+		GEN_ERROR("Unable to read the event recording file");
+		m_data.clear();
+		fclose(pFile);
+		return false;
+	}
+
+	fclose(pFile);
+	return true;
+}//EventReplayer::open
+
+void EventReplayer::close() {
+	m_data.clear();
+	m_pos = 0;
+	m_frame = 0;
+	m_numReplayed = 0;
+	m_numSkipped = 0;
+}//EventReplayer::close
+
+//---------------------------------------------------------------------------------------------------------------------
+// Events that can't be recreated (an unregistered type, or a deserialize() that fails) are skipped rather than ending
+// the replay.
+//---------------------------------------------------------------------------------------------------------------------
+unsigned int EventReplayer::replayFrame( IEventManager& manager ) {
+	unsigned int numQueued = 0;
+	EventReader in(m_data.empty() ? NULL : &m_data[0], m_data.size());
+	in.skip(m_pos);
+
+	while( in.remaining() > 0 ) {
+		size_t entryPos = in.position();
+		EventRecordEntry entry;
+		EventRecordHeader header;
+		if( !in.readBytes(&entry, sizeof(entry)) || !ReadEventHeader(in, header) ) {
+			GEN_ERROR("Event recording is truncated");
+			m_pos = m_data.size();
+			break;
+		}
+
+		if( entry.frame > m_frame ) {
+			m_pos = entryPos;  // belongs to a later frame
+			break;
+		}
+
+		IEventDataPtr pEvent;
+		if( m_replayFromDispatch || !(entry.flags & EVENT_RECORD_FROM_DISPATCH) )
+			pEvent = m_factory.create(header.type);
+
+		bool replay = (pEvent != NULL);
+		if( !replay ) {
+			in.skip(header.size);
+		}
+		else {
+			if( ReadEventPayload(*pEvent, header, in) ) {
+				manager.queueEvent(pEvent);
+				++numQueued;
+			}
+			else {
+				replay = false;
+			}
+		}
+
+		if( replay )
+			++m_numReplayed;
+		else
+			++m_numSkipped;
+
+		if( in.hasFailed() ) {
+			GEN_ERROR("Event recording is corrupt");
+			m_pos = m_data.size();
+			break;
+		}
+		m_pos = in.position();
+	}
+
+	++m_frame;
+	return numQueued;
+}//EventReplayer::replayFrame
+
+}
@@ -0,0 +1,99 @@
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "EventFactory.h"
+#include "EventManager.h"
+
+namespace genesis {
+
+// Recordings start with "GEVR" and a format version, then hold one EventRecordEntry + serialized event per queueEvent()
+const unsigned short EVENTRECORDER_FORMAT_VERSION = 1;
+const size_t EVENTRECORDER_BUFFER_SIZE = 64 * 1024;  // also the largest event that can be recorded
+
+enum EventRecordFlags {
+	EVENT_RECORD_FROM_DISPATCH = 0x1,  // queued by a listener while update() was dispatching
+};
+
+struct EventRecordEntry {
+	unsigned int		frame;  // the number of update()s that had finished when the event was queued
+	unsigned short		flags;  // EventRecordFlags
+	unsigned short		reserved;
+	unsigned long long	timeNs;  // since recording started
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventRecorder class
+//
+// Writes every event that goes through queueEvent() to a file.  Events are serialized into one reused buffer which is
+// written out when it fills up, so recording doesn't allocate and only touches the disk every few hundred events.
+// Events whose serialize() fails or that don't fit in the buffer are counted and skipped.
+//---------------------------------------------------------------------------------------------------------------------
+class EventRecorder {
+	FILE*				m_pFile;
+	std::vector<char>	m_buffer;
+	size_t				m_bufferUsed;
+	unsigned int		m_frame;
+	unsigned long long	m_startNs;
+	unsigned long		m_numRecorded;
+	unsigned long		m_numSkipped;
+
+public:
+	EventRecorder();
+	~EventRecorder();
+
+	bool start( const std::string& fileName );
+	void stop();
+	bool isRecording() const { return (m_pFile != NULL); }
+
+	void record( const IEventData& event, unsigned short flags );
+	void nextFrame() { ++m_frame; }
+
+	unsigned long getNumRecorded() const { return m_numRecorded; }
+	unsigned long getNumSkipped() const { return m_numSkipped; }
+
+private:
+	void flush();
+
+	EventRecorder( const EventRecorder& );
+	EventRecorder& operator=( const EventRecorder& );
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventReplayer class
+//
+// Plays a recording back into an event manager one frame at a time.  Call replayFrame() right before each update() and
+// the manager sees the same events, in the same order and in the same frames, as the session that was recorded.
+// Events that listeners queued during dispatch are skipped by default, since the listeners will queue them again.
+// Events are constructed through an EventFactory, so every recorded event type has to be registered with it.
+//---------------------------------------------------------------------------------------------------------------------
+class EventReplayer {
+	const EventFactory&	m_factory;
+	std::vector<char>	m_data;
+	size_t				m_pos;
+	unsigned int		m_frame;
+	bool				m_replayFromDispatch;
+	unsigned long		m_numReplayed;
+	unsigned long		m_numSkipped;
+
+public:
+	explicit EventReplayer( const EventFactory& factory = g_eventFactory );
+
+	bool open( const std::string& fileName );  // reads the whole recording into memory
+	void close();
+
+	void setReplayFromDispatch( bool replay ) { m_replayFromDispatch = replay; }
+	unsigned int replayFrame( IEventManager& manager );  // queues the next frame's events and returns how many
+	bool isFinished() const { return (m_pos >= m_data.size()); }
+
+	unsigned int getFrame() const { return m_frame; }
+	unsigned long getNumReplayed() const { return m_numReplayed; }
+	unsigned long getNumSkipped() const { return m_numSkipped; }
+};
+
+}
+
+#endif /* EVENT_RECORDER_H */
@@ -0,0 +1,71 @@
+#include "EventSerializer.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+size_t EventReader::beginSection( size_t numBytes ) {
+	size_t previousEnd = m_size;
+	if( numBytes > m_size - m_pos )
+		m_failed = true;
+	else
+		m_size = m_pos + numBytes;
+	return previousEnd;
+}//EventReader::beginSection
+
+//---------------------------------------------------------------------------------------------------------------------
+// Skips whatever the section's reader didn't consume, so the next read starts after the section.
+//---------------------------------------------------------------------------------------------------------------------
+void EventReader::endSection( size_t previousEnd ) {
+	m_pos = m_size;
+	m_size = previousEnd;
+}//EventReader::endSection
+
+bool WriteEvent( const IEventData& event, EventWriter& out ) {
+	EventRecordHeader header;
+	header.type = (unsigned int)event.getEventType();
+	header.version = event.getSchemaVersion();
+	header.reserved = 0;
+	header.size = 0;
+
+	size_t headerOffset = out.size();
+	if( !out.writeBytes(&header, sizeof(header)) )
+		return false;
+
+	if( !event.serialize(out) || out.isOverflowed() )
+		return false;
+
+	header.size = (unsigned int)(out.size() - headerOffset - sizeof(header));
+	out.patch(headerOffset, header);
+	return true;
+}//WriteEvent
+
+bool ReadEventHeader( EventReader& in, EventRecordHeader& outHeader ) {
+	return in.readBytes(&outHeader, sizeof(outHeader));
+}//ReadEventHeader
+
+//---------------------------------------------------------------------------------------------------------------------
+// Reads an event's payload with the reader limited to it, so a bad deserialize() can't run into the next record.
+//---------------------------------------------------------------------------------------------------------------------
+bool ReadEventPayload( IEventData& event, const EventRecordHeader& header, EventReader& in ) {
+	if( header.type != (unsigned int)event.getEventType() ) {
+		GEN_ERROR("Serialized event type doesn't match the event it is being read into");
+		in.skip(header.size);
+		return false;
+	}
+
+	if( header.version > event.getSchemaVersion() )
+		GEN_WARNING("Reading an event written with a newer schema version; unknown fields will be skipped");
+
+	size_t previousEnd = in.beginSection(header.size);
+	if( in.hasFailed() )
+		return false;
+
+	in.setVersion(header.version);
+	bool success = event.deserialize(in) && !in.hasFailed();
+	in.endSection(previousEnd);
+	in.setVersion(0);
+
+	return success;
+}//ReadEventPayload
+
+}
@@ -0,0 +1,146 @@
+#ifndef EVENT_SERIALIZER_H
+#define EVENT_SERIALIZER_H
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "EventManager.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventWriter class
+//
+// Appends binary data to a buffer owned by the caller, so serializing an event never allocates.  Values are written in
+// host byte order with no padding.  A write that doesn't fit sets the overflow flag and is dropped, along with every
+// write after it; callers check isOverflowed() (or the bool returns) once at the end instead of after every field.
+//---------------------------------------------------------------------------------------------------------------------
+class EventWriter {
+	char*			m_pBuffer;
+	size_t			m_capacity;
+	size_t			m_size;
+	bool			m_overflowed;
+
+public:
+	EventWriter( void* pBuffer, size_t capacity ) : m_pBuffer((char*)pBuffer), m_capacity(capacity), m_size(0), m_overflowed(false) {}
+
+	template <class T>
+	bool write( const T& value ) {
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "EventWriter::write() only takes numbers and enums");
+		return writeBytes(&value, sizeof(T));
+	}
+
+	bool writeBytes( const void* pData, size_t numBytes ) {
+		if( m_overflowed || numBytes > m_capacity - m_size ) {
+			m_overflowed = true;
+			return false;
+		}
+		memcpy(m_pBuffer + m_size, pData, numBytes);
+		m_size += numBytes;
+		return true;
+	}
+
+	bool writeString( const std::string& value ) {  // 32 bit length followed by the characters
+		return write((unsigned int)value.size()) && writeBytes(value.data(), value.size());
+	}
+
+	// writes value at an offset that has already been written, e.g. a size that is only known afterwards
+	template <class T>
+	void patch( size_t offset, const T& value ) {
+		GEN_ASSERT(offset + sizeof(T) <= m_size);
+		memcpy(m_pBuffer + offset, &value, sizeof(T));
+	}
+
+	void reset() { m_size = 0; m_overflowed = false; }
+
+	const char* data() const { return m_pBuffer; }
+	size_t size() const { return m_size; }
+	size_t capacity() const { return m_capacity; }
+	bool isOverflowed() const { return m_overflowed; }
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventReader class
+//
+// Reads back what an EventWriter wrote.  A read past the end of the data fails, zero fills its output and leaves the
+// reader failed, so a truncated or corrupt record can be detected once after deserializing.  While an event is being
+// deserialized, getVersion() is the schema version the event was written with.
+//---------------------------------------------------------------------------------------------------------------------
+class EventReader {
+	const char*		m_pBuffer;
+	size_t			m_size;
+	size_t			m_pos;
+	unsigned short	m_version;
+	bool			m_failed;
+
+public:
+	EventReader( const void* pBuffer, size_t size ) : m_pBuffer((const char*)pBuffer), m_size(size), m_pos(0), m_version(0), m_failed(false) {}
+
+	template <class T>
+	bool read( T& value ) {
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "EventReader::read() only takes numbers and enums");
+		return readBytes(&value, sizeof(T));
+	}
+
+	bool readBytes( void* pData, size_t numBytes ) {
+		if( m_failed || numBytes > m_size - m_pos ) {
+			m_failed = true;
+			memset(pData, 0, numBytes);
+			return false;
+		}
+		memcpy(pData, m_pBuffer + m_pos, numBytes);
+		m_pos += numBytes;
+		return true;
+	}
+
+	bool readString( std::string& value ) {
+		unsigned int length = 0;
+		if( !read(length) || length > m_size - m_pos ) {
+			m_failed = true;
+			value.clear();
+			return false;
+		}
+		value.assign(m_pBuffer + m_pos, length);
+		m_pos += length;
+		return true;
+	}
+
+	bool skip( size_t numBytes ) {
+		if( m_failed || numBytes > m_size - m_pos ) {
+			m_failed = true;
+			return false;
+		}
+		m_pos += numBytes;
+		return true;
+	}
+
+	// limits the reader to the next numBytes, e.g. one event's payload; returns the previous end for endSection()
+	size_t beginSection( size_t numBytes );
+	void endSection( size_t previousEnd );
+
+	unsigned short getVersion() const { return m_version; }
+	void setVersion( unsigned short version ) { m_version = version; }
+
+	size_t position() const { return m_pos; }
+	size_t remaining() const { return m_size - m_pos; }
+	bool hasFailed() const { return m_failed; }
+};
+
+// Every serialized event starts with this header.  size lets a reader skip events it doesn't know and the fields that
+// a newer version of an event appended after the ones it knows about.
+struct EventRecordHeader {
+	unsigned int	type;  // event types are 32 bit ids
+	unsigned short	version;  // the event's getSchemaVersion() when it was written
+	unsigned short	reserved;
+	unsigned int	size;  // payload bytes following the header
+};
+
+bool WriteEvent( const IEventData& event, EventWriter& out );  // header and payload
+bool ReadEventHeader( EventReader& in, EventRecordHeader& outHeader );
+bool ReadEventPayload( IEventData& event, const EventRecordHeader& header, EventReader& in );  // always consumes header.size bytes
+
+}
+
+#endif /* EVENT_SERIALIZER_H */
@@ -0,0 +1,186 @@
+#include "EventTimerWheel.h"
+
+namespace genesis {
+
+static EventTimerHandle MakeTimerHandle( unsigned int index, unsigned int generation ) {
+	return ((EventTimerHandle)generation << 32) | (EventTimerHandle)(index + 1);  // never 0
+}//MakeTimerHandle
+
+EventTimerWheel::EventTimerWheel( unsigned long long startMicros ) {
+	m_freeList = kNONE;
+	m_startMicros = startMicros;
+	m_currentTick = 0;
+	m_numPending = 0;
+
+	for( unsigned int i = 0; i < kNUM_LISTS; ++i ) {
+		m_lists[i].head = kNONE;
+		m_lists[i].tail = kNONE;
+	}
+}//EventTimerWheel::EventTimerWheel
+
+//---------------------------------------------------------------------------------------------------------------------
+// The expiry is rounded up to a whole tick, so an event never comes due early.  A time that the wheel has already
+// passed fires on the next advance(), without waiting for another tick.
+//---------------------------------------------------------------------------------------------------------------------
+EventTimerHandle EventTimerWheel::schedule( const IEventDataPtr& pEvent, unsigned long long timeMicros ) {
+	unsigned long long expiryTick = 0;
+	if( timeMicros > m_startMicros )
+		expiryTick = (timeMicros - m_startMicros + kTICK_MICROS - 1) / kTICK_MICROS;
+	unsigned int index = m_freeList;
+	if( index != kNONE ) {
+		m_freeList = m_timers[index].next;
+	}
+	else {
+		index = (unsigned int)m_timers.size();
+		m_timers.push_back(Timer());
+		m_timers[index].generation = 0;
+	}
+
+	Timer& timer = m_timers[index];
+	timer.pEvent = pEvent;
+	timer.expiryTick = expiryTick;
+	timer.list = kNONE;
+	if( expiryTick <= m_currentTick )
+		link(index, kDUE_LIST);
+	else
+		place(index);
+	++m_numPending;
+
+	return MakeTimerHandle(index, timer.generation);
+}//EventTimerWheel::schedule
+
+bool EventTimerWheel::cancel( EventTimerHandle handle ) {
+	unsigned int index = (unsigned int)(handle & 0xffffffff) - 1;
+	unsigned int generation = (unsigned int)(handle >> 32);
+	if( handle == 0 || index >= m_timers.size() )
+		return false;
+
+	Timer& timer = m_timers[index];
+	if( timer.generation != generation || timer.list == kNONE )
+		return false;  // already fired or cancelled
+
+	unlink(index);
+	release(index);
+	--m_numPending;
+	return true;
+}//EventTimerWheel::cancel
+
+void EventTimerWheel::clear() {
+	for( unsigned int i = 0; i < m_timers.size(); ++i ) {
+		if( m_timers[i].list != kNONE ) {
+			unlink(i);
+			release(i);
+		}
+	}
+	m_numPending = 0;
+}//EventTimerWheel::clear
+
+void EventTimerWheel::advance( unsigned long long nowMicros, std::vector<IEventDataPtr>& outEvents ) {
+	unsigned long long nowTick = (nowMicros > m_startMicros) ? ((nowMicros - m_startMicros) / kTICK_MICROS) : 0;
+
+	expire(kDUE_LIST, outEvents);
+
+	while( m_currentTick < nowTick ) {
+		if( m_numPending == 0 ) {
+			m_currentTick = nowTick;  // nothing to fire, so skip straight there
+			break;
+		}
+
+		++m_currentTick;
+
+		// when a level's slot index wraps to 0, bring the next level's current slot down
+		for( unsigned int level = 1; level <= kLEVELS; ++level ) {
+			unsigned int shift = kSLOT_BITS * level;
+			if( (m_currentTick & ((1ULL << shift) - 1)) != 0 )
+				break;
+
+			if( level == kLEVELS )
+				cascade(kOVERFLOW_LIST);
+			else
+				cascade((level * kSLOTS) + (unsigned int)((m_currentTick >> shift) & (kSLOTS - 1)));
+		}
+
+		expire((unsigned int)(m_currentTick & (kSLOTS - 1)), outEvents);
+	}
+}//EventTimerWheel::advance
+
+void EventTimerWheel::expire( unsigned int list, std::vector<IEventDataPtr>& outEvents ) {
+	while( m_lists[list].head != kNONE ) {
+		unsigned int index = m_lists[list].head;
+		unlink(index);
+		outEvents.push_back(std::move(m_timers[index].pEvent));
+		release(index);
+		--m_numPending;
+	}
+}//EventTimerWheel::expire
+
+//---------------------------------------------------------------------------------------------------------------------
+// Puts a timer in the lowest level whose range covers its expiry.  Slots are picked by the expiry's own bits, so the
+// timer is found again exactly when the current tick reaches that slot of that level.
+//---------------------------------------------------------------------------------------------------------------------
+void EventTimerWheel::place( unsigned int index ) {
+	unsigned long long expiryTick = m_timers[index].expiryTick;
+	unsigned long long delta = expiryTick - m_currentTick;
+
+	for( unsigned int level = 0; level < kLEVELS; ++level ) {
+		unsigned int shift = kSLOT_BITS * level;
+		if( delta < (1ULL << (shift + kSLOT_BITS)) ) {
+			link(index, (level * kSLOTS) + (unsigned int)((expiryTick >> shift) & (kSLOTS - 1)));
+			return;
+		}
+	}
+
+	link(index, kOVERFLOW_LIST);
+}//EventTimerWheel::place
+
+void EventTimerWheel::link( unsigned int index, unsigned int list ) {
+	Timer& timer = m_timers[index];
+	List& slot = m_lists[list];
+	timer.list = list;
+	timer.prev = slot.tail;
+	timer.next = kNONE;
+	if( slot.tail != kNONE )
+		m_timers[slot.tail].next = index;
+	else
+		slot.head = index;
+	slot.tail = index;
+}//EventTimerWheel::link
+
+void EventTimerWheel::unlink( unsigned int index ) {
+	Timer& timer = m_timers[index];
+	List& slot = m_lists[timer.list];
+	if( timer.prev != kNONE )
+		m_timers[timer.prev].next = timer.next;
+	else
+		slot.head = timer.next;
+	if( timer.next != kNONE )
+		m_timers[timer.next].prev = timer.prev;
+	else
+		slot.tail = timer.prev;
+	timer.list = kNONE;
+}//EventTimerWheel::unlink
+
+void EventTimerWheel::release( unsigned int index ) {
+	Timer& timer = m_timers[index];
+	timer.pEvent.reset();
+	++timer.generation;
+	timer.next = m_freeList;
+	m_freeList = index;
+}//EventTimerWheel::release
+
+//---------------------------------------------------------------------------------------------------------------------
+// Re-places every timer in a list relative to the current tick, which moves it down at least one level.
+//---------------------------------------------------------------------------------------------------------------------
+void EventTimerWheel::cascade( unsigned int list ) {
+	unsigned int index = m_lists[list].head;
+	m_lists[list].head = kNONE;
+	m_lists[list].tail = kNONE;
+
+	while( index != kNONE ) {
+		unsigned int next = m_timers[index].next;
+		place(index);
+		index = next;
+	}
+}//EventTimerWheel::cascade
+
+}
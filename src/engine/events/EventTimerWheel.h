@@ -0,0 +1,81 @@
+#ifndef EVENT_TIMER_WHEEL_H
+#define EVENT_TIMER_WHEEL_H
+
+#include <vector>
+
+#include "EventManager.h"
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// EventTimerWheel class
+//
+// Holds events until a point in time, for IEventManager::queueEventAt()/queueEventAfter().  Time is cut into ticks of
+// kTICK_MICROS and timers live in a hierarchy of kLEVELS wheels of kSLOTS slots each: level 0 covers the next 64
+// ticks one slot per tick, level 1 the next 4096 ticks 64 ticks per slot, and so on.  Scheduling and cancelling are
+// O(1) and advancing a tick only touches one level 0 slot, plus an occasional cascade of a higher level slot down into
+// the levels below it, so thousands of pending timers cost next to nothing per frame.  Timers further out than the
+// top level can reach wait in an overflow list that is rechecked whenever the top level wraps.
+//
+// Timers are kept in one vector and linked into their slots by index, with a free list, so once it has grown to the
+// peak number of pending timers scheduling doesn't allocate.  Handles carry a generation count, so a stale handle to a
+// reused timer is simply rejected.
+//---------------------------------------------------------------------------------------------------------------------
+class EventTimerWheel {
+public:
+	static const unsigned int kTICK_MICROS = 1000;
+	static const unsigned int kSLOT_BITS = 6;
+	static const unsigned int kSLOTS = 1 << kSLOT_BITS;
+	static const unsigned int kLEVELS = 4;
+
+private:
+	static const unsigned int kNONE = 0xffffffff;
+	static const unsigned int kOVERFLOW_LIST = kLEVELS * kSLOTS;
+	static const unsigned int kDUE_LIST = kOVERFLOW_LIST + 1;  // scheduled for a time that had already passed
+	static const unsigned int kNUM_LISTS = kDUE_LIST + 1;
+
+	struct Timer {
+		IEventDataPtr		pEvent;
+		unsigned long long	expiryTick;
+		unsigned int		generation;
+		unsigned int		list;  // the slot list it is in, or kNONE if the timer is free
+		unsigned int		prev;
+		unsigned int		next;
+	};
+
+	struct List {
+		unsigned int		head;
+		unsigned int		tail;
+	};
+
+	std::vector<Timer>	m_timers;
+	unsigned int		m_freeList;  // linked through Timer::next
+	List				m_lists[kNUM_LISTS];  // level * kSLOTS + slot, then the overflow and due lists
+	unsigned long long	m_startMicros;  // tick 0
+	unsigned long long	m_currentTick;  // every timer up to and including this tick has fired
+	unsigned int		m_numPending;
+
+public:
+	explicit EventTimerWheel( unsigned long long startMicros );
+
+	EventTimerHandle schedule( const IEventDataPtr& pEvent, unsigned long long timeMicros );
+	bool cancel( EventTimerHandle handle );
+	void clear();
+
+	// moves the wheel up to nowMicros and appends the events that came due to outEvents, earliest first
+	void advance( unsigned long long nowMicros, std::vector<IEventDataPtr>& outEvents );
+
+	unsigned int getNumPending() const { return m_numPending; }
+
+private:
+	void place( unsigned int index );
+	void link( unsigned int index, unsigned int list );
+	void unlink( unsigned int index );
+	void release( unsigned int index );
+	void cascade( unsigned int list );
+	void expire( unsigned int list, std::vector<IEventDataPtr>& outEvents );
+};
+
+}
+
+#endif /* EVENT_TIMER_WHEEL_H */
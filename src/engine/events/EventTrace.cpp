@@ -0,0 +1,28 @@
+#include <cstdio>
+
+#include "EventTrace.h"
+
+namespace genesis {
+
+#ifndef NDEBUG
+LogChannel g_eventsLogChannel("Events");
+LogChannel g_eventLoopLogChannel("EventLoop");
+#endif
+
+std::string EventTraceRecord( const char* op, const IEventData* pEvent, unsigned long n ) {
+	if( !pEvent )
+		return EventTypeTraceRecord(op, EventType(0), n);
+
+	std::string record = EventTypeTraceRecord(op, pEvent->getEventType(), n);
+	record += " name=";
+	record += pEvent->getName();
+	return record;
+}//EventTraceRecord
+
+std::string EventTypeTraceRecord( const char* op, const EventType& type, unsigned long n ) {
+	char buffer[96];
+	snprintf(buffer, sizeof(buffer), "op=%s type=0x%08lx n=%lu", op, (unsigned long)type, n);
+	return std::string(buffer);
+}//EventTypeTraceRecord
+
+}
@@ -0,0 +1,32 @@
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <string>
+
+#include "EventManager.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+// Log channels used by the event system.  Enable them in logging.xml with the "Events" and "EventLoop" tags.  Like
+// the rest of the logging, they don't exist in release builds.
+#ifndef NDEBUG
+extern LogChannel g_eventsLogChannel;
+extern LogChannel g_eventLoopLogChannel;
+#endif
+
+// Builds a structured trace record, one line of key=value pairs so traces can be grepped or loaded into a spreadsheet:
+//     op=dispatch type=0x2750d117 n=3 name=QuitMessage
+// n is an operation specific count (listeners called, queue depth, ...).  The second form is for records about an
+// event type rather than a single event.
+std::string EventTraceRecord( const char* op, const IEventData* pEvent, unsigned long n );
+std::string EventTypeTraceRecord( const char* op, const EventType& type, unsigned long n );
+
+// Traces an event operation.  Compiles away in release builds and costs one branch on a cached flag when the channel
+// is disabled; the record is only built when it's actually going to be written.
+#define GEN_EVENT_TRACE(channel, op, pEvent, n) GEN_LOG_CHANNEL(channel, EventTraceRecord((op), (pEvent), (n)))
+#define GEN_EVENT_TYPE_TRACE(channel, op, type, n) GEN_LOG_CHANNEL(channel, EventTypeTraceRecord((op), (type), (n)))
+
+}
+
+#endif /* EVENT_TRACE_H */
@@ -0,0 +1,265 @@
+#include <atomic>
+#include <chrono>
+
+#include "RealtimeEventQueue.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+static std::atomic<unsigned long> s_nextRealtimeQueueId(1);
+
+// Each thread remembers the producer queue it last pushed to so the common case doesn't touch the registry lock.
+struct RealtimeProducerCache {
+	unsigned long				queueId;
+	RealtimeProducerQueue*		pProducer;
+};
+static thread_local RealtimeProducerCache t_producerCache = { 0, NULL };
+
+RealtimeProducerQueue::RealtimeProducerQueue( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy )
+	: m_name(name), m_threadId(std::this_thread::get_id()), m_policy(policy)
+{
+	m_ring.resize(capacity > 0 ? capacity : 1);
+	m_head = 0;
+	m_count = 0;
+	m_retired = false;
+
+	m_stats.name = name;
+	m_stats.capacity = (unsigned int)m_ring.size();
+	m_stats.pending = 0;
+	m_stats.highWaterMark = 0;
+	m_stats.pushed = 0;
+	m_stats.dropped = 0;
+	m_stats.coalesced = 0;
+	m_stats.blocked = 0;
+	m_stats.blockFailed = 0;
+}//RealtimeProducerQueue::RealtimeProducerQueue
+
+//---------------------------------------------------------------------------------------------------------------------
+// canBlock is false when the caller is the thread that drains the queue, so waiting for room would never end.
+//---------------------------------------------------------------------------------------------------------------------
+bool RealtimeProducerQueue::push( const IEventDataPtr& pEvent, bool canBlock ) {
+	tbb::spin_mutex::scoped_lock lock(m_mutex);
+
+	if( m_count == m_ring.size() ) {
+		switch( m_policy ) {
+			case REALTIME_OVERFLOW_DROP_OLDEST :
+			{
+				dropFront();
+				break;
+			}
+
+			case REALTIME_OVERFLOW_DROP_NEWEST :
+			{
+				++m_stats.dropped;
+				return false;
+			}
+
+			case REALTIME_OVERFLOW_BLOCK :
+			{
+				// wait for the main loop to make room, unless it has stopped updating
+				if( canBlock ) {
+					++m_stats.blocked;
+					std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REALTIME_BLOCK_TIMEOUT_MS);
+					while( m_count == m_ring.size() && std::chrono::steady_clock::now() < deadline ) {
+						lock.release();
+						std::this_thread::yield();
+						lock.acquire(m_mutex);
+					}
+				}
+				if( m_count == m_ring.size() ) {
+					++m_stats.blockFailed;
+					++m_stats.dropped;
+					return false;
+				}
+				break;
+			}
+
+			case REALTIME_OVERFLOW_COALESCE :
+			{
+				if( replacePendingOfType(pEvent) ) {
+					++m_stats.coalesced;
+					return true;
+				}
+				dropFront();
+				break;
+			}
+		}
+	}
+
+	pushBack(pEvent);
+	return true;
+}//RealtimeProducerQueue::push
+
+unsigned int RealtimeProducerQueue::drain( std::vector<IEventDataPtr>& outEvents, unsigned int maxEvents ) {
+	tbb::spin_mutex::scoped_lock lock(m_mutex);
+
+	unsigned int numDrained = (m_count < maxEvents) ? m_count : maxEvents;
+	for( unsigned int i = 0; i < numDrained; ++i ) {
+		outEvents.push_back(std::move(m_ring[m_head]));
+		m_head = (m_head + 1) % m_ring.size();
+	}
+	m_count -= numDrained;
+
+	return numDrained;
+}//RealtimeProducerQueue::drain
+
+void RealtimeProducerQueue::getStats( RealtimeProducerStats& outStats ) {
+	tbb::spin_mutex::scoped_lock lock(m_mutex);
+	outStats = m_stats;
+	outStats.pending = m_count;
+}//RealtimeProducerQueue::getStats
+
+void RealtimeProducerQueue::pushBack( const IEventDataPtr& pEvent ) {
+	m_ring[(m_head + m_count) % m_ring.size()] = pEvent;
+	++m_count;
+	++m_stats.pushed;
+	if( m_count > m_stats.highWaterMark )
+		m_stats.highWaterMark = m_count;
+}//RealtimeProducerQueue::pushBack
+
+void RealtimeProducerQueue::dropFront() {
+	m_ring[m_head].reset();
+	m_head = (m_head + 1) % m_ring.size();
+	--m_count;
+	++m_stats.dropped;
+}//RealtimeProducerQueue::dropFront
+
+//---------------------------------------------------------------------------------------------------------------------
+// Replaces the newest pending event with the same type as pEvent.  This is only done when the ring is full, so the
+// linear scan is paid by the producer that's flooding, never by the main loop.
+//---------------------------------------------------------------------------------------------------------------------
+bool RealtimeProducerQueue::replacePendingOfType( const IEventDataPtr& pEvent ) {
+	const EventType& type = pEvent->getEventType();
+	for( unsigned int i = m_count; i > 0; --i ) {
+		IEventDataPtr& pPending = m_ring[(m_head + i - 1) % m_ring.size()];
+		if( pPending->getEventType() == type ) {
+			pPending = pEvent;
+			return true;
+		}
+	}
+
+	return false;
+}//RealtimeProducerQueue::replacePendingOfType
+
+
+RealtimeEventQueue::RealtimeEventQueue( unsigned int defaultCapacity, RealtimeOverflowPolicy defaultPolicy ) {
+	m_id = s_nextRealtimeQueueId.fetch_add(1);
+	m_nextProducer = 0;
+	m_consumerThreadId.store(std::thread::id());
+	m_defaultCapacity = defaultCapacity;
+	m_defaultPolicy = defaultPolicy;
+}//RealtimeEventQueue::RealtimeEventQueue
+
+//---------------------------------------------------------------------------------------------------------------------
+// Producer threads must have stopped pushing before the queue is destroyed.
+//---------------------------------------------------------------------------------------------------------------------
+RealtimeEventQueue::~RealtimeEventQueue() {
+	for( auto it = m_producers.begin(); it != m_producers.end(); ++it )
+		delete (*it);
+	m_producers.clear();
+}//RealtimeEventQueue::~RealtimeEventQueue
+
+bool RealtimeEventQueue::registerProducer( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy ) {
+	tbb::spin_mutex::scoped_lock lock(m_producersMutex);
+
+	std::thread::id threadId = std::this_thread::get_id();
+	if( findProducerLocked(threadId) ) {
+		GEN_WARNING("Attempting to register a realtime event producer twice from the same thread");
+		return false;
+	}
+
+	RealtimeProducerQueue* pProducer = new RealtimeProducerQueue(name, capacity, policy);
+	m_producers.push_back(pProducer);
+	t_producerCache.queueId = m_id;
+	t_producerCache.pProducer = pProducer;
+
+	return true;
+}//RealtimeEventQueue::registerProducer
+
+//---------------------------------------------------------------------------------------------------------------------
+// Detaches the calling thread.  Events it already pushed are still delivered; the queue is freed once it's drained.
+//---------------------------------------------------------------------------------------------------------------------
+void RealtimeEventQueue::unregisterProducer() {
+	tbb::spin_mutex::scoped_lock lock(m_producersMutex);
+
+	RealtimeProducerQueue* pProducer = findProducerLocked(std::this_thread::get_id());
+	if( pProducer )
+		pProducer->m_retired = true;
+
+	if( t_producerCache.queueId == m_id ) {
+		t_producerCache.queueId = 0;
+		t_producerCache.pProducer = NULL;
+	}
+}//RealtimeEventQueue::unregisterProducer
+
+bool RealtimeEventQueue::push( const IEventDataPtr& pEvent ) {
+	RealtimeProducerQueue* pProducer = findProducer();
+	return pProducer->push(pEvent, std::this_thread::get_id() != m_consumerThreadId.load(std::memory_order_relaxed));
+}//RealtimeEventQueue::push
+
+unsigned int RealtimeEventQueue::drain( std::vector<IEventDataPtr>& outEvents, unsigned int maxPerProducer ) {
+	m_consumerThreadId.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+	tbb::spin_mutex::scoped_lock lock(m_producersMutex);
+
+	unsigned int numDrained = 0;
+	size_t numProducers = m_producers.size();
+	for( size_t i = 0; i < numProducers; ++i ) {
+		RealtimeProducerQueue* pProducer = m_producers[(m_nextProducer + i) % numProducers];
+		numDrained += pProducer->drain(outEvents, maxPerProducer);
+	}
+
+	// free the queues of producers that have gone away
+	for( size_t i = 0; i < m_producers.size(); ) {
+		RealtimeProducerQueue* pProducer = m_producers[i];
+		if( pProducer->m_retired && pProducer->m_count == 0 ) {
+			delete pProducer;
+			m_producers[i] = m_producers.back();
+			m_producers.pop_back();
+		}
+		else {
+			++i;
+		}
+	}
+
+	// rotate the starting producer so no one thread always gets drained first
+	m_nextProducer = m_producers.empty() ? 0 : ((m_nextProducer + 1) % m_producers.size());
+
+	return numDrained;
+}//RealtimeEventQueue::drain
+
+void RealtimeEventQueue::getStats( std::vector<RealtimeProducerStats>& outStats ) {
+	tbb::spin_mutex::scoped_lock lock(m_producersMutex);
+
+	outStats.resize(m_producers.size());
+	for( size_t i = 0; i < m_producers.size(); ++i )
+		m_producers[i]->getStats(outStats[i]);
+}//RealtimeEventQueue::getStats
+
+RealtimeProducerQueue* RealtimeEventQueue::findProducer() {
+	if( t_producerCache.queueId == m_id )
+		return t_producerCache.pProducer;
+
+	tbb::spin_mutex::scoped_lock lock(m_producersMutex);
+
+	RealtimeProducerQueue* pProducer = findProducerLocked(std::this_thread::get_id());
+	if( !pProducer ) {
+		pProducer = new RealtimeProducerQueue("unnamed", m_defaultCapacity, m_defaultPolicy);
+		m_producers.push_back(pProducer);
+	}
+
+	t_producerCache.queueId = m_id;
+	t_producerCache.pProducer = pProducer;
+	return pProducer;
+}//RealtimeEventQueue::findProducer
+
+RealtimeProducerQueue* RealtimeEventQueue::findProducerLocked( std::thread::id threadId ) {
+	for( auto it = m_producers.begin(); it != m_producers.end(); ++it ) {
+		if( (*it)->m_threadId == threadId && !(*it)->m_retired )
+			return (*it);
+	}
+
+	return NULL;
+}//RealtimeEventQueue::findProducerLocked
+
+}
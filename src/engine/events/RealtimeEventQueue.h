@@ -0,0 +1,104 @@
+#ifndef REALTIME_EVENT_QUEUE_H
+#define REALTIME_EVENT_QUEUE_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tbb/spin_mutex.h>
+
+#include "EventManager.h"
+
+namespace genesis {
+
+// longest a push waits for room under REALTIME_OVERFLOW_BLOCK before it gives up and drops the event
+const unsigned int REALTIME_BLOCK_TIMEOUT_MS = 100;
+
+struct RealtimeProducerStats {
+	std::string		name;
+	unsigned int	capacity;
+	unsigned int	pending;  // events waiting to be drained by the main loop
+	unsigned int	highWaterMark;  // most events that were ever pending at once
+	unsigned long	pushed;  // events accepted into the ring
+	unsigned long	dropped;  // events lost to DROP_OLDEST/DROP_NEWEST/COALESCE, and to BLOCK giving up
+	unsigned long	coalesced;  // events that replaced a pending event of the same type
+	unsigned long	blocked;  // pushes that had to wait for room under BLOCK
+	unsigned long	blockFailed;  // BLOCK pushes that were dropped because the wait timed out or would have deadlocked
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// RealtimeProducerQueue class
+//
+// A bounded ring owned by a single producer thread and drained by the main loop.  The only contention on its lock is
+// between that one producer and the consumer, so it's effectively uncontended.  What happens when the ring is full is
+// decided by the producer's RealtimeOverflowPolicy.
+//---------------------------------------------------------------------------------------------------------------------
+class RealtimeProducerQueue {
+	friend class RealtimeEventQueue;
+
+	std::string					m_name;
+	std::thread::id				m_threadId;
+	RealtimeOverflowPolicy		m_policy;
+	std::vector<IEventDataPtr>	m_ring;
+	unsigned int				m_head;
+	unsigned int				m_count;
+	bool						m_retired;  // the producer unregistered; delete once drained
+	RealtimeProducerStats		m_stats;
+	tbb::spin_mutex				m_mutex;
+
+public:
+	RealtimeProducerQueue( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy );
+
+	bool push( const IEventDataPtr& pEvent, bool canBlock );
+	unsigned int drain( std::vector<IEventDataPtr>& outEvents, unsigned int maxEvents );  // appends to outEvents
+	void getStats( RealtimeProducerStats& outStats );
+
+private:
+	void pushBack( const IEventDataPtr& pEvent );
+	void dropFront();
+	bool replacePendingOfType( const IEventDataPtr& pEvent );
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// RealtimeEventQueue class
+//
+// Multi-producer ingestion for events coming from other threads (network, audio, loaders, ...).  Each producer thread
+// gets its own bounded RealtimeProducerQueue the first time it pushes, either with the defaults or with the settings
+// it registered via registerProducer().  The consumer drains each producer a bounded amount at a time, so a flood
+// from one thread is absorbed by that thread's overflow policy instead of stalling the main loop.
+//---------------------------------------------------------------------------------------------------------------------
+class RealtimeEventQueue {
+	typedef std::vector<RealtimeProducerQueue*> ProducerList;
+
+	ProducerList				m_producers;
+	tbb::spin_mutex				m_producersMutex;
+	unsigned long				m_id;  // unique per instance; validates each thread's cached producer
+	unsigned int				m_nextProducer;  // round-robin start for drain()
+	std::atomic<std::thread::id>	m_consumerThreadId;  // the last thread to drain; it mustn't block on its own queue
+	unsigned int				m_defaultCapacity;
+	RealtimeOverflowPolicy		m_defaultPolicy;
+
+public:
+	explicit RealtimeEventQueue( unsigned int defaultCapacity = 1024, RealtimeOverflowPolicy defaultPolicy = REALTIME_OVERFLOW_DROP_OLDEST );
+	~RealtimeEventQueue();
+
+	// producer side; these act on the calling thread's queue
+	bool registerProducer( const std::string& name, unsigned int capacity, RealtimeOverflowPolicy policy );
+	void unregisterProducer();
+	bool push( const IEventDataPtr& pEvent );
+
+	// consumer side; takes at most maxPerProducer events from each producer and returns the number taken
+	unsigned int drain( std::vector<IEventDataPtr>& outEvents, unsigned int maxPerProducer );
+	void getStats( std::vector<RealtimeProducerStats>& outStats );
+
+private:
+	RealtimeProducerQueue* findProducer();  // the calling thread's queue, creating it if needed
+	RealtimeProducerQueue* findProducerLocked( std::thread::id threadId );
+
+	RealtimeEventQueue( const RealtimeEventQueue& );
+	RealtimeEventQueue& operator=( const RealtimeEventQueue& );
+};
+
+}
+
+#endif /* REALTIME_EVENT_QUEUE_H */
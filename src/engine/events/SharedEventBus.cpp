@@ -0,0 +1,362 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SharedEventBus.h"
+#include "utilities/logger.h"
+
+namespace genesis {
+
+static const unsigned int SHAREDEVENTBUS_MAGIC = 0x53455642;  // "SEVB"
+static const unsigned int SHAREDEVENTBUS_VERSION = 1;
+static const unsigned int SHAREDEVENTBUS_MIN_RING_BYTES = 4096;
+static const unsigned int SHAREDEVENTBUS_ALIGNMENT = 8;
+
+// the start of the segment; magic is written last by create(), so open() knows the rest is ready
+struct SharedEventBusHeader {
+	std::atomic<unsigned int>	magic;
+	unsigned int				version;
+	unsigned int				ringBytes;
+	char						pad[64 - (3 * sizeof(unsigned int))];
+};
+
+// Both counters only ever increase; a counter's position in the ring is its value masked by ringBytes - 1.  They sit
+// on separate cache lines so the producer and consumer don't false share.  The ring's bytes follow this struct.
+struct SharedEventBus::Ring {
+	std::atomic<unsigned long long>		head;  // bytes written; only the producer stores to it
+	char								pad0[64 - sizeof(std::atomic<unsigned long long>)];
+	std::atomic<unsigned long long>		tail;  // bytes read; only the consumer stores to it
+	char								pad1[64 - sizeof(std::atomic<unsigned long long>)];
+
+	char* data() { return (char*)(this + 1); }
+};
+
+enum SharedEventMessageFlags {
+	SHAREDEVENT_MESSAGE_PADDING = 0x1,  // fills the end of the ring when a message didn't fit; skip it
+};
+
+// Every message starts on an 8 byte boundary with this prefix, followed by an EventRecordHeader and the payload.  The
+// two together are 24 bytes, which keeps POD payloads 8 byte aligned.  Padding messages only use size and flags.
+struct SharedEventMessage {
+	unsigned int	size;  // the whole message including this prefix, rounded up to SHAREDEVENTBUS_ALIGNMENT
+	unsigned int	flags;
+	unsigned int	reserved;
+};
+
+static size_t AlignMessageSize( size_t numBytes ) {
+	return (numBytes + SHAREDEVENTBUS_ALIGNMENT - 1) & ~(size_t)(SHAREDEVENTBUS_ALIGNMENT - 1);
+}//AlignMessageSize
+
+SharedEventBus::SharedEventBus( IEventManager& manager, const EventFactory& factory )
+	: m_manager(manager), m_factory(factory)
+{
+	m_pSegment = NULL;
+	m_segmentSize = 0;
+	m_isOwner = false;
+	m_pOutgoing = NULL;
+	m_pIncoming = NULL;
+	m_ringBytes = 0;
+	m_pPending = NULL;
+	m_pendingHead = 0;
+	m_pendingBytes = 0;
+	m_forwardDelegate = fastdelegate::MakeDelegate(this, &SharedEventBus::onForwardedEvent);
+	m_stats = SharedEventBusStats();
+}//SharedEventBus::SharedEventBus
+
+SharedEventBus::~SharedEventBus() {
+	close();
+}//SharedEventBus::~SharedEventBus
+
+bool SharedEventBus::create( const std::string& name, unsigned int ringBytes ) {
+	return map(name, true, ringBytes);
+}//SharedEventBus::create
+
+bool SharedEventBus::open( const std::string& name ) {
+	return map(name, false, 0);
+}//SharedEventBus::open
+
+void SharedEventBus::close() {
+	for( auto it = m_forwardedTypes.begin(); it != m_forwardedTypes.end(); ++it )
+		m_manager.removeListener(m_forwardDelegate, *it);
+	m_forwardedTypes.clear();
+
+	if( m_pSegment ) {
+		munmap(m_pSegment, m_segmentSize);
+		if( m_isOwner )
+			shm_unlink(m_name.c_str());
+	}
+
+	m_pSegment = NULL;
+	m_segmentSize = 0;
+	m_isOwner = false;
+	m_pOutgoing = NULL;
+	m_pIncoming = NULL;
+	m_pPending = NULL;
+}//SharedEventBus::close
+
+//---------------------------------------------------------------------------------------------------------------------
+// Events of the type are sent to the other process as the local manager dispatches them.
+//---------------------------------------------------------------------------------------------------------------------
+bool SharedEventBus::forwardEventType( const EventType& type ) {
+	if( !m_forwardedTypes.insert(type).second )
+		return false;
+
+	return m_manager.addListener(m_forwardDelegate, type);
+}//SharedEventBus::forwardEventType
+
+bool SharedEventBus::stopForwardingEventType( const EventType& type ) {
+	if( m_forwardedTypes.erase(type) == 0 )
+		return false;
+
+	return m_manager.removeListener(m_forwardDelegate, type);
+}//SharedEventBus::stopForwardingEventType
+
+bool SharedEventBus::send( const IEventDataPtr& pEvent ) {
+	if( !m_pSegment || !pEvent )
+		return false;
+
+	// serialize straight into the ring; if the event doesn't fit before the end, wrap around and try once more
+	size_t minBytes = sizeof(SharedEventMessage) + sizeof(EventRecordHeader);
+	for( int attempt = 0; attempt < 2; ++attempt ) {
+		size_t available = 0;
+		char* pMessage = reserve(minBytes, available);
+		if( !pMessage )
+			break;
+
+		EventWriter out(pMessage + sizeof(SharedEventMessage), available - sizeof(SharedEventMessage));
+		if( WriteEvent(*pEvent, out) ) {
+			commit(sizeof(SharedEventMessage) + out.size());
+			return true;
+		}
+
+		if( !out.isOverflowed() ) {
+			GEN_WARNING("Unable to serialize an event for the shared event bus");
+			m_pPending = NULL;
+			++m_stats.dropped;
+			return false;
+		}
+		minBytes = available + SHAREDEVENTBUS_ALIGNMENT;
+	}
+
+	m_pPending = NULL;
+	++m_stats.dropped;
+	return false;
+}//SharedEventBus::send
+
+void* SharedEventBus::beginSend( const EventType& type, size_t numBytes ) {
+	GEN_ASSERT(!m_pPending);
+	if( !m_pSegment )
+		return NULL;
+
+	size_t available = 0;
+	char* pMessage = reserve(sizeof(SharedEventMessage) + sizeof(EventRecordHeader) + numBytes, available);
+	if( !pMessage ) {
+		++m_stats.dropped;
+		return NULL;
+	}
+
+	EventRecordHeader header;
+	header.type = (unsigned int)type;
+	header.version = 1;
+	header.reserved = 0;
+	header.size = (unsigned int)numBytes;
+	memcpy(pMessage + sizeof(SharedEventMessage), &header, sizeof(header));
+	m_pendingBytes = sizeof(SharedEventMessage) + sizeof(header) + numBytes;
+
+	return pMessage + sizeof(SharedEventMessage) + sizeof(header);
+}//SharedEventBus::beginSend
+
+void SharedEventBus::endSend() {
+	GEN_ASSERT(m_pPending);
+	commit(m_pendingBytes);
+}//SharedEventBus::endSend
+
+//---------------------------------------------------------------------------------------------------------------------
+// Receives whatever the other process has sent.  POD listeners are called with the payload in place; everything else
+// is recreated through the factory and queued on the local manager.  The ring space is handed back to the sender once
+// at the end.
+//---------------------------------------------------------------------------------------------------------------------
+unsigned int SharedEventBus::poll( unsigned int maxMessages ) {
+	if( !m_pSegment )
+		return 0;
+
+	unsigned long long tail = m_pIncoming->tail.load(std::memory_order_relaxed);
+	const unsigned long long head = m_pIncoming->head.load(std::memory_order_acquire);
+	const unsigned long long mask = m_ringBytes - 1;
+
+	unsigned int numReceived = 0;
+	while( tail != head && numReceived < maxMessages ) {
+		const char* pData = m_pIncoming->data() + (tail & mask);
+		const SharedEventMessage* pMessage = (const SharedEventMessage*)pData;
+		unsigned int minSize = (pMessage->flags & SHAREDEVENT_MESSAGE_PADDING) ? SHAREDEVENTBUS_ALIGNMENT : sizeof(SharedEventMessage);
+		if( pMessage->size < minSize || pMessage->size > head - tail ) {
+			GEN_ERROR("Corrupt message in the shared event bus; discarding the rest of the ring");
+			tail = head;
+			break;
+		}
+
+		if( pMessage->flags & SHAREDEVENT_MESSAGE_PADDING ) {
+			tail += pMessage->size;
+			continue;
+		}
+
+		EventReader in(pData + sizeof(SharedEventMessage), pMessage->size - sizeof(SharedEventMessage));
+		EventRecordHeader header;
+		bool accepted = false;
+		if( ReadEventHeader(in, header) && header.size <= in.remaining() ) {
+			auto podIt = m_podListeners.find(header.type);
+			if( podIt != m_podListeners.end() ) {
+				podIt->second(header.type, pData + sizeof(SharedEventMessage) + sizeof(header), header.size);
+				accepted = true;
+			}
+			else if( m_forwardedTypes.find(header.type) == m_forwardedTypes.end() ) {
+				IEventDataPtr pEvent = m_factory.create(header.type);
+				if( pEvent && ReadEventPayload(*pEvent, header, in) ) {
+					m_manager.queueEvent(pEvent);
+					accepted = true;
+				}
+			}
+		}
+
+		if( accepted )
+			++m_stats.received;
+		else
+			++m_stats.rejected;
+
+		tail += pMessage->size;
+		++numReceived;
+	}
+
+	m_pIncoming->tail.store(tail, std::memory_order_release);
+	return numReceived;
+}//SharedEventBus::poll
+
+//---------------------------------------------------------------------------------------------------------------------
+// The segment is laid out as the header, then the creator's outgoing ring, then the opener's outgoing ring.
+//---------------------------------------------------------------------------------------------------------------------
+bool SharedEventBus::map( const std::string& name, bool create, unsigned int ringBytes ) {
+	close();
+
+	int fd = -1;
+	if( create ) {
+		unsigned int size = SHAREDEVENTBUS_MIN_RING_BYTES;
+		while( size < ringBytes )
+			size <<= 1;
+		ringBytes = size;
+		m_segmentSize = sizeof(SharedEventBusHeader) + (2 * (sizeof(Ring) + ringBytes));
+
+		shm_unlink(name.c_str());  // a segment left behind by a process that crashed
+		fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if( fd < 0 || ftruncate(fd, m_segmentSize) != 0 ) {
+			GEN_ERROR("Unable to create the shared event bus segment");
+			if( fd >= 0 ) {
+				::close(fd);
+				shm_unlink(name.c_str());
+			}
+			return false;
+		}
+	}
+	else {
+		struct stat info;
+		fd = shm_open(name.c_str(), O_RDWR, 0600);
+		if( fd < 0 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SharedEventBusHeader) ) {
+			if( fd >= 0 )
+				::close(fd);
+			return false;
+		}
+		m_segmentSize = info.st_size;
+	}
+
+	void* pSegment = mmap(NULL, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if( pSegment == MAP_FAILED ) {
+		GEN_ERROR("Unable to map the shared event bus segment");
+		if( create )
+			shm_unlink(name.c_str());
+		return false;
+	}
+
+	SharedEventBusHeader* pHeader = (SharedEventBusHeader*)pSegment;
+	if( create ) {
+		// ftruncate zero filled the segment, so both rings start out empty
+		pHeader->version = SHAREDEVENTBUS_VERSION;
+		pHeader->ringBytes = ringBytes;
+		pHeader->magic.store(SHAREDEVENTBUS_MAGIC, std::memory_order_release);
+	}
+	else {
+		if( pHeader->magic.load(std::memory_order_acquire) != SHAREDEVENTBUS_MAGIC || pHeader->version != SHAREDEVENTBUS_VERSION ||
+			m_segmentSize != sizeof(SharedEventBusHeader) + (2 * (sizeof(Ring) + pHeader->ringBytes)) ) {
+			munmap(pSegment, m_segmentSize);
+			return false;
+		}
+		ringBytes = pHeader->ringBytes;
+	}
+
+	Ring* pFirstRing = (Ring*)((char*)pSegment + sizeof(SharedEventBusHeader));
+	Ring* pSecondRing = (Ring*)(pFirstRing->data() + ringBytes);
+
+	m_name = name;
+	m_pSegment = pSegment;
+	m_isOwner = create;
+	m_ringBytes = ringBytes;
+	m_pOutgoing = create ? pFirstRing : pSecondRing;
+	m_pIncoming = create ? pSecondRing : pFirstRing;
+
+	return true;
+}//SharedEventBus::map
+
+void SharedEventBus::onForwardedEvent( const IEventDataPtr& pEvent ) {
+	send(pEvent);
+}//SharedEventBus::onForwardedEvent
+
+//---------------------------------------------------------------------------------------------------------------------
+// Finds at least minBytes of contiguous free space at the head of the outgoing ring and returns how much there is in
+// outAvailable.  If the space before the end of the ring is too small it is filled with a padding message and the
+// message starts over at the beginning.  Returns NULL if the ring is too full.
+//---------------------------------------------------------------------------------------------------------------------
+char* SharedEventBus::reserve( size_t minBytes, size_t& outAvailable ) {
+	minBytes = AlignMessageSize(minBytes);
+	unsigned long long head = m_pOutgoing->head.load(std::memory_order_relaxed);
+	unsigned long long tail = m_pOutgoing->tail.load(std::memory_order_acquire);
+	size_t freeBytes = m_ringBytes - (size_t)(head - tail);
+	size_t offset = (size_t)(head & (m_ringBytes - 1));
+	size_t contiguous = m_ringBytes - offset;
+
+	if( contiguous < minBytes ) {
+		if( freeBytes < contiguous + minBytes )
+			return NULL;
+
+		SharedEventMessage* pPadding = (SharedEventMessage*)(m_pOutgoing->data() + offset);
+		pPadding->size = (unsigned int)contiguous;
+		pPadding->flags = SHAREDEVENT_MESSAGE_PADDING;
+		head += contiguous;
+		m_pOutgoing->head.store(head, std::memory_order_release);
+
+		freeBytes -= contiguous;
+		offset = 0;
+		contiguous = m_ringBytes;
+	}
+	else if( freeBytes < minBytes ) {
+		return NULL;
+	}
+
+	outAvailable = (freeBytes < contiguous) ? freeBytes : contiguous;
+	m_pPending = m_pOutgoing->data() + offset;
+	m_pendingHead = head;
+	return m_pPending;
+}//SharedEventBus::reserve
+
+void SharedEventBus::commit( size_t numBytes ) {
+	SharedEventMessage* pMessage = (SharedEventMessage*)m_pPending;
+	pMessage->size = (unsigned int)AlignMessageSize(numBytes);
+	pMessage->flags = 0;
+	pMessage->reserved = 0;
+	++m_stats.sent;
+	m_stats.bytesSent += pMessage->size;
+
+	m_pOutgoing->head.store(m_pendingHead + pMessage->size, std::memory_order_release);
+	m_pPending = NULL;
+}//SharedEventBus::commit
+
+}
@@ -0,0 +1,123 @@
+#ifndef SHARED_EVENT_BUS_H
+#define SHARED_EVENT_BUS_H
+
+#include <atomic>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "EventFactory.h"
+#include "EventManager.h"
+#include "EventSerializer.h"
+
+namespace genesis {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The shared event bus needs lock-free 64 bit atomics to work across processes");
+
+const unsigned int SHAREDEVENTBUS_DEFAULT_RING_BYTES = 1024 * 1024;
+const unsigned int SHAREDEVENTBUS_MAX_POLL = 4096;  // messages poll() takes by default before returning
+
+// Called with a POD event's payload while it is still in shared memory; the pointer is only valid during the call
+typedef fastdelegate::FastDelegate3<const EventType&, const void*, size_t> SharedPodDelegate;
+
+struct SharedEventBusStats {
+	unsigned long		sent;
+	unsigned long		received;
+	unsigned long		dropped;  // sends that didn't fit in the outgoing ring
+	unsigned long		rejected;  // incoming events of unknown types, types we forward, or that failed to deserialize
+	unsigned long long	bytesSent;
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// SharedEventBus class
+//
+// Forwards selected event types between the event managers of two processes on the same machine, e.g. the client and
+// a simulation process running next to it.  One side create()s a named POSIX shared memory segment and the other
+// open()s it.  The segment holds a single producer/single consumer byte ring for each direction, synchronized only
+// with acquire/release head and tail counters, so neither side ever blocks or makes a system call to send or receive.
+//
+// Events of a forwarded type are serialized straight into the outgoing ring when the local manager dispatches them.
+// The other side's poll() recreates them through the EventFactory and queues them on its manager.  Each type should
+// be forwarded in one direction only; incoming events of a type this side forwards are rejected so they can't bounce
+// back and forth.
+//
+// Plain-old-data events can skip serialization entirely: the sender constructs the payload directly in the ring with
+// beginSendPod()/endSend(), and the receiver reads it in place through a SharedPodDelegate.
+//
+// Each ring has exactly one producer and one consumer, so send() and poll() must each only be called from one thread,
+// normally the main loop.
+//---------------------------------------------------------------------------------------------------------------------
+class SharedEventBus {
+	struct Ring;
+
+	IEventManager&			m_manager;
+	const EventFactory&		m_factory;
+	std::string				m_name;
+	void*					m_pSegment;
+	size_t					m_segmentSize;
+	bool					m_isOwner;
+	Ring*					m_pOutgoing;
+	Ring*					m_pIncoming;
+	unsigned int			m_ringBytes;
+	char*					m_pPending;  // the message between beginSend() and endSend()
+	unsigned long long		m_pendingHead;  // where m_pPending starts in the outgoing ring's sequence of bytes
+	size_t					m_pendingBytes;
+	EventListenerDelegate	m_forwardDelegate;
+	std::unordered_set<EventType>	m_forwardedTypes;
+	std::unordered_map<EventType, SharedPodDelegate>	m_podListeners;
+	SharedEventBusStats		m_stats;
+
+public:
+	explicit SharedEventBus( IEventManager& manager, const EventFactory& factory = g_eventFactory );
+	~SharedEventBus();
+
+	bool create( const std::string& name, unsigned int ringBytes = SHAREDEVENTBUS_DEFAULT_RING_BYTES );
+	bool open( const std::string& name );  // fails until the other side has finished create()
+	void close();
+	bool isConnected() const { return (m_pSegment != NULL); }
+	unsigned int getRingBytes() const { return m_ringBytes; }  // of each direction, after rounding up
+
+	// outgoing
+	bool forwardEventType( const EventType& type );
+	bool stopForwardingEventType( const EventType& type );
+	bool send( const IEventDataPtr& pEvent );
+
+	template <class TPod>
+	TPod* beginSendPod( const EventType& type ) {
+		static_assert(std::is_trivially_copyable<TPod>::value, "Only trivially copyable events can be sent in place");
+		return (TPod*)beginSend(type, sizeof(TPod));
+	}
+	void* beginSend( const EventType& type, size_t numBytes );  // NULL if the ring is full
+	void endSend();
+
+	template <class TPod>
+	bool sendPod( const EventType& type, const TPod& value ) {
+		TPod* pValue = beginSendPod<TPod>(type);
+		if( !pValue )
+			return false;
+		*pValue = value;
+		endSend();
+		return true;
+	}
+
+	// incoming
+	void addPodListener( const EventType& type, const SharedPodDelegate& podDelegate ) { m_podListeners[type] = podDelegate; }
+	void removePodListener( const EventType& type ) { m_podListeners.erase(type); }
+	unsigned int poll( unsigned int maxMessages = SHAREDEVENTBUS_MAX_POLL );  // returns the number of messages received
+
+	const SharedEventBusStats& getStats() const { return m_stats; }
+
+private:
+	bool map( const std::string& name, bool create, unsigned int ringBytes );
+	void onForwardedEvent( const IEventDataPtr& pEvent );
+	char* reserve( size_t minBytes, size_t& outAvailable );
+	void commit( size_t numBytes );
+
+	SharedEventBus( const SharedEventBus& );
+	SharedEventBus& operator=( const SharedEventBus& );
+};
+
+}
+
+#endif /* SHARED_EVENT_BUS_H */
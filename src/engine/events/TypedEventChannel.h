@@ -0,0 +1,147 @@
+#ifndef TYPED_EVENT_CHANNEL_H
+#define TYPED_EVENT_CHANNEL_H
+
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace genesis {
+
+typedef unsigned int TypedSubscription;  // 0 is never a valid subscription
+
+// Hands out a dense index per event class the first time the class is used with the typed API
+class TypedEventIndexBase {
+protected:
+	static unsigned int next() {
+		static std::atomic<unsigned int> s_nextIndex(0);
+		return s_nextIndex.fetch_add(1);
+	}
+};
+
+template <class TEvent>
+class TypedEventIndex : private TypedEventIndexBase {
+public:
+	static unsigned int get() {
+		static const unsigned int s_index = next();
+		return s_index;
+	}
+};
+
+class ITypedEventChannel {
+public:
+	virtual ~ITypedEventChannel() {}
+	virtual unsigned int flush() = 0;  // dispatches the pending events and returns how many there were
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// TypedEventChannel class
+//
+// Storage and handlers for one event class used through EventManager::subscribe()/emit().  Emitted events are
+// constructed in place in a vector of TEvent and handed to the handlers by const reference, so there is no virtual
+// call, cast or shared_ptr per event.  Both vectors keep their capacity between updates, so a steady stream of events
+// doesn't allocate.
+//---------------------------------------------------------------------------------------------------------------------
+template <class TEvent>
+class TypedEventChannel : public ITypedEventChannel {
+public:
+	typedef std::function<void ( const TEvent& )> Handler;
+
+private:
+	struct Subscriber {
+		TypedSubscription	id;
+		Handler				handler;
+		bool				active;  // false once unsubscribed during a flush; removed afterwards
+	};
+
+	std::vector<TEvent>		m_pending;
+	std::vector<TEvent>		m_dispatching;  // the batch being flushed; events emitted by handlers wait in m_pending
+	std::vector<Subscriber>	m_subscribers;
+	std::vector<Subscriber>	m_added;  // subscribed during a flush; m_subscribers can't grow while it's being walked
+	TypedSubscription		m_nextId;
+	bool					m_isFlushing;
+	bool					m_hasRemoved;
+
+public:
+	TypedEventChannel() : m_nextId(1), m_isFlushing(false), m_hasRemoved(false) {}
+
+	TypedSubscription subscribe( const Handler& handler ) {
+		Subscriber subscriber;
+		subscriber.id = m_nextId++;
+		subscriber.handler = handler;
+		subscriber.active = true;
+		if( m_isFlushing )
+			m_added.push_back(subscriber);
+		else
+			m_subscribers.push_back(subscriber);
+		return subscriber.id;
+	}
+
+	bool unsubscribe( TypedSubscription id ) {
+		for( auto it = m_added.begin(); it != m_added.end(); ++it ) {
+			if( it->id == id ) {
+				m_added.erase(it);
+				return true;
+			}
+		}
+
+		for( auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it ) {
+			if( it->id == id && it->active ) {
+				if( m_isFlushing ) {
+					it->active = false;  // the handler may be the one that is running
+					m_hasRemoved = true;
+				}
+				else {
+					m_subscribers.erase(it);
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool hasSubscribers() const { return !m_subscribers.empty() || !m_added.empty(); }
+	bool hasPending() const { return !m_pending.empty(); }
+
+	// returns true if this is the first pending event, so the owner knows to schedule a flush
+	template <class... Args>
+	bool emit( Args&&... args ) {
+		m_pending.emplace_back(std::forward<Args>(args)...);
+		return (m_pending.size() == 1);
+	}
+
+	virtual unsigned int flush() {
+		m_dispatching.swap(m_pending);
+		m_isFlushing = true;
+
+		for( auto eventIt = m_dispatching.begin(); eventIt != m_dispatching.end(); ++eventIt ) {
+			for( auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it ) {
+				if( it->active )
+					it->handler(*eventIt);
+			}
+		}
+
+		m_isFlushing = false;
+		if( m_hasRemoved ) {
+			for( size_t i = 0; i < m_subscribers.size(); ) {
+				if( !m_subscribers[i].active )
+					m_subscribers.erase(m_subscribers.begin() + i);
+				else
+					++i;
+			}
+			m_hasRemoved = false;
+		}
+		if( !m_added.empty() ) {
+			m_subscribers.insert(m_subscribers.end(), m_added.begin(), m_added.end());
+			m_added.clear();
+		}
+
+		unsigned int numDispatched = (unsigned int)m_dispatching.size();
+		m_dispatching.clear();
+		return numDispatched;
+	}
+};
+
+}
+
+#endif /* TYPED_EVENT_CHANNEL_H */
@@ -0,0 +1,299 @@
+#ifndef COROUTINE_PROCESS_H
+#define COROUTINE_PROCESS_H
+
+// The engine itself builds as C++11, so this is all in the header; coroutine processes are only there for code built
+// with coroutine support, which compiles them in with it.
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <cstddef>
+#include <new>
+
+#include "process.h"
+#include "processmanager.h"
+#include "events/EventManager.h"
+#include "utilities/memorypool.h"
+
+namespace genesis {
+
+const size_t COROUTINE_FRAME_SIZES[] = { 128, 256, 512, 1024, 2048 };
+const unsigned int COROUTINE_NUM_FRAME_POOLS = sizeof(COROUTINE_FRAME_SIZES) / sizeof(COROUTINE_FRAME_SIZES[0]);
+
+// the smallest pool a frame of this size fits in, or NULL if it's too big for all of them
+inline MemoryPool* CoroutineFramePool( size_t size ) {
+	static MemoryPool* s_pPools[COROUTINE_NUM_FRAME_POOLS] = {};
+	for( unsigned int i = 0; i < COROUTINE_NUM_FRAME_POOLS; ++i ) {
+		if( size <= COROUTINE_FRAME_SIZES[i] ) {
+			if( !s_pPools[i] )
+				s_pPools[i] = new MemoryPool(COROUTINE_FRAME_SIZES[i], 64);  // like the other pools, never destroyed
+			return s_pPools[i];
+		}
+	}
+	return NULL;
+}//CoroutineFramePool
+
+// Coroutine frames come from a few MemoryPools of fixed sizes; a frame too big for the largest one goes to the heap
+// and is counted as a heap allocation.
+inline void* AllocateCoroutineFrame( size_t size ) {
+	MemoryPool* pPool = CoroutineFramePool(size);
+	if( !pPool ) {
+		MemoryPool::countHeapAllocation();
+		return ::operator new(size);
+	}
+
+	void* pFrame = pPool->allocate();
+	if( !pFrame )
+		throw std::bad_alloc();
+	return pFrame;
+}//AllocateCoroutineFrame
+
+inline void FreeCoroutineFrame( void* pFrame, size_t size ) {
+	MemoryPool* pPool = CoroutineFramePool(size);
+	if( pPool )
+		pPool->free(pFrame);
+	else
+		::operator delete(pFrame);
+}//FreeCoroutineFrame
+
+//---------------------------------------------------------------------------------------------------------------------
+// ProcessTask class
+//
+// What a CoroutineProcess body returns.  It owns the coroutine frame.  The body doesn't start until the process gets
+// its first update.
+//---------------------------------------------------------------------------------------------------------------------
+class ProcessTask {
+public:
+	struct promise_type {
+		bool				isFailed;  // the body let an exception out
+
+		promise_type() : isFailed(false) {}
+
+		ProcessTask get_return_object() { return ProcessTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return std::suspend_always(); }
+		std::suspend_always final_suspend() noexcept { return std::suspend_always(); }
+		void return_void() {}
+		void unhandled_exception() { isFailed = true; }
+
+		static void* operator new( size_t size ) { return AllocateCoroutineFrame(size); }
+		static void operator delete( void* pFrame, size_t size ) { FreeCoroutineFrame(pFrame, size); }
+	};
+
+private:
+	std::coroutine_handle<promise_type>		m_handle;
+
+public:
+	ProcessTask() {}
+	explicit ProcessTask( std::coroutine_handle<promise_type> handle ) : m_handle(handle) {}
+	ProcessTask( ProcessTask&& other ) : m_handle(other.m_handle) { other.m_handle = nullptr; }
+	ProcessTask& operator=( ProcessTask&& other );
+	~ProcessTask() { if( m_handle ) m_handle.destroy(); }
+
+	bool isValid() const { return (bool)m_handle; }
+	bool isDone() const { GEN_ASSERT(isValid()); return m_handle.done(); }
+	bool isFailed() const { GEN_ASSERT(isValid()); return m_handle.promise().isFailed; }
+	void resume() { GEN_ASSERT(isValid()); m_handle.resume(); }
+
+private:
+	ProcessTask( const ProcessTask& );
+	ProcessTask& operator=( const ProcessTask& );
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// CoroutineProcess class
+//
+// A process whose body is a coroutine, so it can be written as straight-line code that waits with co_await:
+//
+//		ProcessTask run() override {
+//			co_await delay(500);
+//			co_await waitForSignal(kSIGNAL_LEVEL_LOADED);
+//			IEventDataPtr pEvent = co_await waitForEvent(eventMgr, EvtData_Destroy_Actor::sk_EventType);
+//			if( co_await waitFor(MakeProcess<FadeProcess>()) != Process::SUCCEEDED )
+//				fail();
+//		}
+//
+// While it waits for anything but the next tick, the process sleeps in the process mgr, so it isn't updated again
+// until what it waits for has happened.  The process succeeds when the body returns while it is still alive, and fails
+// if an exception escapes the body.  Calling succeed() or fail() from the body ends the process too, but the body
+// should co_return right after.
+//
+// The body calls the process mgr, so coroutine processes always run on the main thread.
+//---------------------------------------------------------------------------------------------------------------------
+class CoroutineProcess : public Process {
+	ProcessTask			m_task;
+	unsigned long		m_deltaMs;  // of the update that resumed the body
+
+public:
+	struct NextTickAwaiter {
+		CoroutineProcess&	process;
+
+		bool await_ready() const { return false; }
+		void await_suspend( std::coroutine_handle<> ) {}
+		unsigned long await_resume() const { return process.m_deltaMs; }
+	};
+
+	struct DelayAwaiter {
+		CoroutineProcess&	process;
+		unsigned long		durationMs;
+
+		bool await_ready() const { return false; }
+		bool await_suspend( std::coroutine_handle<> ) { return process.getManager()->sleep(process, durationMs); }
+		unsigned long await_resume() const { return process.m_deltaMs; }
+	};
+
+	struct SignalAwaiter {
+		CoroutineProcess&	process;
+		ProcessSignal		signal;
+		unsigned long		timeoutMs;
+
+		bool await_ready() const { return false; }
+		bool await_suspend( std::coroutine_handle<> ) { return process.getManager()->sleepUntilSignal(process, signal, timeoutMs); }
+		void await_resume() const {}
+	};
+
+	class EventAwaiter {
+		CoroutineProcess&	m_process;
+		IEventManager&		m_eventManager;
+		EventType			m_type;
+		IEventDataPtr		m_pEvent;
+		bool				m_isListening;
+
+	public:
+		EventAwaiter( CoroutineProcess& process, IEventManager& eventManager, const EventType& type );
+		~EventAwaiter();
+
+		bool await_ready() const { return false; }
+		bool await_suspend( std::coroutine_handle<> );
+		IEventDataPtr await_resume() { return m_pEvent; }  // NULL if the process was woken some other way
+
+	private:
+		void onEvent( const IEventDataPtr& pEvent );
+		void stopListening();
+
+		EventAwaiter( const EventAwaiter& );  // it's listening through a delegate bound to itself
+		EventAwaiter& operator=( const EventAwaiter& );
+	};
+
+	struct ProcessAwaiter {
+		CoroutineProcess&	process;
+		StrongProcessPtr	pTarget;
+
+		bool await_ready() const { return false; }
+		bool await_suspend( std::coroutine_handle<> );
+		Process::State await_resume() const { return pTarget ? pTarget->getState() : Process::ABORTED; }  // how it ended
+	};
+
+public:
+	CoroutineProcess();
+
+protected:
+	virtual ProcessTask run() = 0;  // the body
+
+	virtual void onInit();
+	virtual void onUpdate( unsigned long deltaMs );
+
+	// awaitables for the body
+	NextTickAwaiter nextTick() { return NextTickAwaiter{*this}; }
+	DelayAwaiter delay( unsigned long durationMs ) { return DelayAwaiter{*this, durationMs}; }
+	SignalAwaiter waitForSignal( ProcessSignal signal, unsigned long timeoutMs = 0 ) { return SignalAwaiter{*this, signal, timeoutMs}; }
+	EventAwaiter waitForEvent( IEventManager& eventManager, const EventType& type ) { return EventAwaiter(*this, eventManager, type); }
+	ProcessAwaiter waitFor( StrongProcessPtr pProcess ) { return ProcessAwaiter{*this, pProcess}; }  // attaches it first if it isn't
+
+	unsigned long getDeltaMs() const { return m_deltaMs; }
+};
+
+inline ProcessTask& ProcessTask::operator=( ProcessTask&& other ) {
+	if( this != &other ) {
+		if( m_handle )
+			m_handle.destroy();
+		m_handle = other.m_handle;
+		other.m_handle = nullptr;
+	}
+	return *this;
+}//ProcessTask::operator=
+
+inline CoroutineProcess::CoroutineProcess() {
+	m_deltaMs = 0;
+}//CoroutineProcess::CoroutineProcess
+
+inline void CoroutineProcess::onInit() {
+	Process::onInit();
+	m_task = run();
+}//CoroutineProcess::onInit
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runs the body up to its next co_await.  If it put the process to sleep, the process mgr won't update it again until
+// it wakes it.
+//---------------------------------------------------------------------------------------------------------------------
+inline void CoroutineProcess::onUpdate( unsigned long deltaMs ) {
+	if( !m_task.isValid() ) {
+		GEN_ERROR("Coroutine process has no body");
+		fail();
+		return;
+	}
+
+	m_deltaMs = deltaMs;
+	m_task.resume();
+	if( !m_task.isDone() || !isAlive() )
+		return;
+
+	if( m_task.isFailed() )
+		fail();
+	else
+		succeed();
+}//CoroutineProcess::onUpdate
+
+inline CoroutineProcess::EventAwaiter::EventAwaiter( CoroutineProcess& process, IEventManager& eventManager, const EventType& type )
+	: m_process(process), m_eventManager(eventManager), m_type(type), m_isListening(false)
+{
+}//CoroutineProcess::EventAwaiter::EventAwaiter
+
+inline CoroutineProcess::EventAwaiter::~EventAwaiter() {
+	stopListening();  // the process ended while waiting
+}//CoroutineProcess::EventAwaiter::~EventAwaiter
+
+inline bool CoroutineProcess::EventAwaiter::await_suspend( std::coroutine_handle<> ) {
+	m_isListening = m_eventManager.addListener(fastdelegate::MakeDelegate(this, &EventAwaiter::onEvent), m_type);
+	if( !m_isListening )
+		return false;
+
+	if( !m_process.getManager()->sleepUntilWoken(m_process) ) {
+		stopListening();
+		return false;
+	}
+	return true;
+}//CoroutineProcess::EventAwaiter::await_suspend
+
+inline void CoroutineProcess::EventAwaiter::onEvent( const IEventDataPtr& pEvent ) {
+	if( !m_isListening )
+		return;
+
+	m_pEvent = pEvent;
+	stopListening();  // only the first one counts
+	if( m_process.getManager() )
+		m_process.getManager()->wake(m_process);
+}//CoroutineProcess::EventAwaiter::onEvent
+
+inline void CoroutineProcess::EventAwaiter::stopListening() {
+	if( m_isListening ) {
+		m_eventManager.removeListener(fastdelegate::MakeDelegate(this, &EventAwaiter::onEvent), m_type);
+		m_isListening = false;
+	}
+}//CoroutineProcess::EventAwaiter::stopListening
+
+inline bool CoroutineProcess::ProcessAwaiter::await_suspend( std::coroutine_handle<> ) {
+	ProcessManager* pManager = process.getManager();
+	if( !pTarget )
+		return false;
+	if( !pTarget->getManager() ) {
+		if( pTarget->getState() != Process::UNINITIALIZED )
+			return false;  // it has already ended
+		pManager->attachProcess(pTarget);
+	}
+	return pManager->sleepUntilDone(process, *pTarget);
+}//CoroutineProcess::ProcessAwaiter::await_suspend
+
+}
+
+#endif /* __cpp_impl_coroutine */
+
+#endif /* COROUTINE_PROCESS_H */
@@ -1,9 +1,19 @@
 #include "process.h"
+#include "processmanager.h"
 
 namespace genesis {
 
 Process::Process() {
 	m_state = UNINITIALIZED;
+	m_pManager = NULL;
+	m_managerSlot = kNOT_ATTACHED;
+	m_concurrency = PROCESS_MAIN_THREAD;
+	m_dataKey = 0;
+	m_priority = PROCESS_PRIORITY_EVERY_TICK;
+	m_lastUpdateMs = 0;
+	m_numPrerequisites = 0;
+	m_rateGroup = 0;
+	m_pTypeCounters = NULL;
 }//Process::Process
 
 Process::~Process() {
@@ -12,6 +22,11 @@ Process::~Process() {
 	}
 }//Process::~Process
 
+void Process::requeue( State prevState ) {
+	if( m_pManager )
+		m_pManager->requeue(*this, prevState);
+}//Process::requeue
+
 StrongProcessPtr Process::removeChild() {
 	if( m_pChild ) {
 		StrongProcessPtr pChild = m_pChild;  // this keeps the child from getting destroyed when we clear it
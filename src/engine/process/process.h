@@ -8,9 +8,26 @@
 namespace genesis {
 
 class Process;
+class ProcessManager;
+struct ProcessTypeCounters;
 typedef std::shared_ptr<Process> StrongProcessPtr;
 typedef std::weak_ptr<Process> WeakProcessPtr;
 
+// Where a running process's onUpdate() may be called from (see Process::setConcurrency())
+enum ProcessConcurrency {
+	PROCESS_MAIN_THREAD,  // on the thread calling updateProcesses(), in turn with the other main thread processes
+	PROCESS_ANY_THREAD,  // on a worker, concurrently with any other worker process
+	PROCESS_SERIALIZED,  // on a worker, but never at the same time as another process with the same data key
+};
+
+// Whether a running process's update can be put off when updateProcesses() runs out of budget (see Process::setPriority())
+enum ProcessPriority {
+	PROCESS_PRIORITY_EVERY_TICK = 0,  // updated every tick whatever the budget; the default
+	PROCESS_PRIORITY_BEST_EFFORT,  // updated in turn with the others like it, as far as the budget goes
+};
+
+typedef unsigned int ProcessRateGroup;  // made by the process mgr (see Process::setRateGroup()); 0 is the variable rate default
+
 //---------------------------------------------------------------------------------------------------------------------
 // Process class
 //
@@ -29,6 +46,8 @@ class Process
 	friend class ProcessManager;
 
 public:
+	enum eConstants { kNOT_ATTACHED = 0xffffffff };
+
 	enum State {
 		// Processes that are neither dead nor alive
 		UNINITIALIZED = 0,  // created but not running
@@ -37,6 +56,7 @@ public:
 		// Living processes
 		RUNNING,  // initialized and running
 		PAUSED,  // initialized but paused
+		SLEEPING,  // initialized but left out of the update tick until the process mgr wakes it
 
 		// Dead processes
 		SUCCEEDED,  // completed successfully
@@ -47,6 +67,15 @@ public:
 private:
 	State				m_state;  // the current state of the process
 	StrongProcessPtr	m_pChild;  // the child process, if any
+	ProcessManager*		m_pManager;  // the process mgr it's attached to, if any
+	unsigned int		m_managerSlot;  // where the process mgr keeps it, or kNOT_ATTACHED
+	ProcessConcurrency	m_concurrency;
+	unsigned long		m_dataKey;  // processes with the same key are never updated concurrently
+	ProcessPriority		m_priority;
+	unsigned long long	m_lastUpdateMs;  // best-effort only: the process mgr time it has been updated up to
+	unsigned int		m_numPrerequisites;  // attached with ProcessManager::attachAfter(): how many haven't succeeded yet
+	ProcessRateGroup	m_rateGroup;
+	ProcessTypeCounters*	m_pTypeCounters;  // the process mgr's stats for this process's class
 
 public:
 	// construction
@@ -61,6 +90,22 @@ protected:
 	virtual void onFail() { }  // called if the process fails (see below)
 	virtual void onAbort() { }  // called if the process is aborted (see below)
 
+	// Lets the process mgr update this process on a worker thread.  Call it before the process starts running, e.g.
+	// from the constructor or onInit().  A worker process's onUpdate() may change its own state and its own child, but
+	// mustn't touch other processes or call the process mgr; onSuccess() and the other exit functions are always called
+	// on the thread running updateProcesses().
+	void setConcurrency( ProcessConcurrency concurrency, unsigned long dataKey = 0 ) { m_concurrency = concurrency; m_dataKey = dataKey; }
+
+	// Lets the process mgr put off this process's updates when the tick is out of budget.  When it does get an update,
+	// deltaMs covers all the time since its last one.  Best-effort processes are always updated on the thread running
+	// updateProcesses(), whatever their concurrency.  Like setConcurrency(), call it before the process starts running.
+	void setPriority( ProcessPriority priority ) { m_priority = priority; }
+
+	// Puts this process in one of the process mgr's rate groups, e.g. a fixed step one, instead of updating it once per
+	// tick with the tick's deltaMs.  Rate group processes are updated on the thread running updateProcesses(), whatever
+	// their concurrency and priority.  Like setConcurrency(), call it before the process starts running.
+	void setRateGroup( ProcessRateGroup group ) { m_rateGroup = group; }
+
 public:
 	// Functions for ending the process.
 	inline void succeed();
@@ -72,10 +117,16 @@ public:
 
 	// accessors
 	State getState() const { return m_state; }
-	bool isAlive() const { return (m_state == RUNNING || m_state == PAUSED); }
+	bool isAlive() const { return (m_state == RUNNING || m_state == PAUSED || m_state == SLEEPING); }
 	bool isDead() const { return (m_state == SUCCEEDED || m_state == FAILED || m_state == ABORTED); }
 	bool isRemoved() const { return (m_state == REMOVED); }
 	bool isPaused() const { return m_state == PAUSED; }
+	bool isSleeping() const { return m_state == SLEEPING; }
+	ProcessManager* getManager() const { return m_pManager; }
+	ProcessConcurrency getConcurrency() const { return m_concurrency; }
+	unsigned long getDataKey() const { return m_dataKey; }
+	ProcessPriority getPriority() const { return m_priority; }
+	ProcessRateGroup getRateGroup() const { return m_rateGroup; }
 
 	// child functions
 	inline void attachChild( StrongProcessPtr pChild );
@@ -84,6 +135,7 @@ public:
 
 private:
 	void setState( State newState ) { m_state = newState; }
+	void requeue( State prevState );  // the tick doesn't visit sleeping or paused processes, so the process mgr is told when they change state
 };
 
 
@@ -91,13 +143,19 @@ private:
 // Inline function definitions
 //---------------------------------------------------------------------------------------------------------------------
 inline void Process::succeed() {
-	GEN_ASSERT(m_state == RUNNING || m_state == PAUSED);
+	GEN_ASSERT(isAlive());
+	State prevState = m_state;
 	m_state = SUCCEEDED;
+	if( prevState == SLEEPING || prevState == PAUSED )
+		requeue(prevState);
 }//Process::succeed
 
 inline void Process::fail() {
-	GEN_ASSERT(m_state == RUNNING || m_state == PAUSED);
+	GEN_ASSERT(isAlive());
+	State prevState = m_state;
 	m_state = FAILED;
+	if( prevState == SLEEPING || prevState == PAUSED )
+		requeue(prevState);
 }//Process::fail
 
 inline void Process::attachChild( StrongProcessPtr pChild ) {
@@ -115,8 +173,10 @@ inline void Process::pause() {
 }//Process::pause
 
 inline void Process::unPause() {
-	if( m_state == PAUSED )
+	if( m_state == PAUSED ) {
 		m_state = RUNNING;
+		requeue(PAUSED);
+	}
 	else
 		GEN_WARNING("Attempting to unpause a process that isn't paused");
 }//Process::unPause
@@ -1,107 +1,974 @@
+#include <algorithm>
+#include <cstdlib>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
 #include "processmanager.h"
+#include "utilities/clock.h"
+#include "utilities/memorypool.h"
 
 namespace genesis {
 
+const unsigned long long PROCESSMANAGER_NO_DEADLINE = ~0ULL;
+
+static std::string TypeName( const std::type_info& type ) {
+	std::string name = type.name();
+#ifdef __GNUG__
+	int status = 0;
+	char* pDemangled = abi::__cxa_demangle(type.name(), NULL, NULL, &status);
+	if( pDemangled ) {
+		if( status == 0 )
+			name = pDemangled;
+		free(pDemangled);
+	}
+#endif
+	return name;
+}//TypeName
+
+// Pushes onto one of the process mgr's arrays.  Growing it is counted with the memory pools' heap allocations, so that
+// ProcessTickStats::heapAllocations covers everything a tick can allocate.
+template <class T>
+static inline void Append( std::vector<T>& items, const T& item ) {
+	if( items.size() == items.capacity() )
+		MemoryPool::countHeapAllocation();
+	items.push_back(item);
+}//Append
+
+ProcessTypeCounters::ProcessTypeCounters( const std::string& typeName )
+	: name(typeName), updates(0), totalNs(0), maxNs(0)
+{
+	lastTickUpdates = 0;
+	lastTickNs = 0;
+	markUpdates = 0;
+	markNs = 0;
+}//ProcessTypeCounters::ProcessTypeCounters
+
+ProcessManager::ProcessManager() {
+	m_freeSlot = Process::kNOT_ATTACHED;
+	m_isUpdating = false;
+	m_isRunningWorkers = false;
+	m_bestEffortCursor = 0;
+	m_timeMs = 0;
+	m_tickBaseMs = 0;
+	m_numSleeping = 0;
+	m_numPaused = 0;
+	m_numBlocked = 0;
+	m_isProfilingTypes = false;
+	m_tickStats = ProcessTickStats();
+}//ProcessManager::ProcessManager
+
 ProcessManager::~ProcessManager() {
 	clearAllProcesses();
 }//ProcessManager::~ProcessManager
 
 //---------------------------------------------------------------------------------------------------------------------
-// The process update tick.  Called every logic tick.  This function returns the number of process chains that
-// succeeded in the upper 32 bits and the number of process chains that failed or were aborted in the lower 32 bits.
-//---------------------------------------------------------------------------------------------------------------------
-unsigned int ProcessManager::updateProcesses( unsigned long deltaMs ) {
-	unsigned short int successCount = 0;
-	unsigned short int failCount = 0;
-
-	ProcessList::iterator it = m_processList.begin();
-	while( it != m_processList.end() ) {
-		StrongProcessPtr pCurrProcess = (*it);
-
-		// save the iterator and increment the old one in case we need to remove this process from the list
-		ProcessList::iterator thisIt = it;
-		++it;
-
-		// process is uninitialized, so initialize it
-		if( pCurrProcess->getState() == Process::UNINITIALIZED )
-			pCurrProcess->onInit();
-
-		// give the process an update tick if it's running
-		if( pCurrProcess->getState() == Process::RUNNING )
-			pCurrProcess->onUpdate(deltaMs);
-
-		// check to see if the process is dead
-		if( pCurrProcess->isDead() ) {
-			// run the appropriate exit function
-			switch( pCurrProcess->getState() ) {
-				case Process::SUCCEEDED :
-				{
-					pCurrProcess->onSuccess();
-					StrongProcessPtr pChild = pCurrProcess->removeChild();
-					if( pChild )
-						attachProcess(pChild);
-					else
-						++successCount;  // only counts if the whole chain completed
-					break;
-				}
+// The process update tick.  Called every logic tick.  Returns what the tick did; the stats stay valid until the next
+// call.
+//---------------------------------------------------------------------------------------------------------------------
+const ProcessTickStats& ProcessManager::updateProcesses( unsigned long deltaMs, unsigned long maxMicros ) {
+	const unsigned long long startNs = Clock::nowNs();
+	const unsigned long long deadlineNs = (maxMicros == kINFINITE) ? PROCESSMANAGER_NO_DEADLINE : startNs + ((unsigned long long)maxMicros * 1000);
+	const unsigned long startHeapAllocations = MemoryPool::getHeapAllocationCount();
+	m_tickStats = ProcessTickStats();
+	m_isUpdating = true;
 
-				case Process::FAILED :
-				{
-					pCurrProcess->onFail();
-					++failCount;
-					break;
-				}
+	// wake the processes whose sleep is over; they get this tick's update along with the others
+	m_tickBaseMs = m_timeMs;
+	m_timeMs += deltaMs;
+	wakeTimers();
 
-				case Process::ABORTED :
-				{
-					pCurrProcess->onAbort();
-					++failCount;
-					break;
-				}
+	// initialize the processes attached since the last update; the ones that come up running get their first tick below
+	m_initBatch.swap(m_newProcesses);
+	for( auto it = m_initBatch.begin(); it != m_initBatch.end(); ++it ) {
+		Process* pProcess = *it;
+		if( pProcess->m_state == Process::UNINITIALIZED )
+			pProcess->onInit();
 
-				default:
-				{
-					break;
-				}
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+	m_initBatch.clear();
+
+	// finish the processes that ended outside the tick
+	for( unsigned int i = 0; i < m_endedProcesses.size(); ) {
+		Process* pProcess = m_endedProcesses[i];
+		if( pProcess->m_state == Process::REMOVED ) {
+			++i;
+			continue;
+		}
+
+		remove(m_endedProcesses, i);
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+
+	// the rate groups, which may take any number of steps this tick
+	if( !m_rateGroups.empty() )
+		runRateGroups(deltaMs);
+
+	// give the main thread processes an update tick; a process that stops running is swapped with the last one, which
+	// is then updated in its place
+	for( unsigned int i = 0; i < m_runningProcesses.size(); ) {
+		Process* pProcess = m_runningProcesses[i];
+		if( pProcess->m_state == Process::RUNNING ) {
+			UpdateProcess(pProcess, deltaMs, m_isProfilingTypes);
+			if( pProcess->m_state == Process::RUNNING ) {
+				++i;
+				continue;
 			}
+		}
 
-			// remove the process and destroy it
-			m_processList.erase(thisIt);
+		remove(m_runningProcesses, i);
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+
+	// then the worker ones, and deal with the ones that stopped running on this thread
+	if( !m_parallelProcesses.empty() || !m_processGroups.empty() ) {
+		runWorkerProcesses(deltaMs);
+
+		sweep(m_parallelProcesses);
+		for( unsigned int i = 0; i < m_processGroups.size(); ) {
+			sweepGroup(i);
+			if( !m_processGroups[i].processes.empty() ) {
+				++i;
+				continue;
+			}
+
+			m_groupIndices.erase(m_processGroups[i].dataKey);
+			if( i + 1 < m_processGroups.size() ) {
+				m_processGroups[i].dataKey = m_processGroups.back().dataKey;
+				m_processGroups[i].processes.swap(m_processGroups.back().processes);
+				m_groupIndices[m_processGroups[i].dataKey] = i;
+			}
+			m_processGroups.pop_back();
 		}
 	}
 
-	return ((successCount << 16) | failCount);
+	// the best-effort processes get what's left of the budget
+	if( !m_bestEffortProcesses.empty() )
+		runBestEffortProcesses(deadlineNs);
+
+	m_tickBaseMs = m_timeMs;
+	m_isUpdating = false;
+	if( m_isProfilingTypes )
+		updateTypeTickStats();
+
+	m_tickStats.running = getRunningCount();
+	m_tickStats.sleeping = m_numSleeping;
+	m_tickStats.paused = m_numPaused;
+	m_tickStats.blocked = m_numBlocked;
+	m_tickStats.tickNs = Clock::nowNs() - startNs;
+	m_tickStats.heapAllocations = MemoryPool::getHeapAllocationCount() - startHeapAllocations;
+	return m_tickStats;
 }//ProcessManager::updateProcesses
 
+//---------------------------------------------------------------------------------------------------------------------
+// A fixed step group whose pending time calls for more than its limit of steps takes the limit and lets go of the rest,
+// so a long hitch doesn't snowball into ever longer ticks.
+//---------------------------------------------------------------------------------------------------------------------
+void ProcessManager::runRateGroups( unsigned long deltaMs ) {
+	for( unsigned int i = 0; i < m_rateGroups.size(); ++i ) {
+		RateGroup& group = m_rateGroups[i];
+		group.pendingMs += deltaMs;
+
+		if( group.kind == RATE_GROUP_FIXED_STEP ) {
+			unsigned long numSteps = group.pendingMs / group.stepMs;
+			if( numSteps > group.maxSteps ) {
+				unsigned long droppedMs = (numSteps - group.maxSteps) * group.stepMs;
+				group.pendingMs -= droppedMs;
+				m_tickStats.droppedMs += droppedMs;
+				numSteps = group.maxSteps;
+			}
+
+			const unsigned long stepMs = group.stepMs;
+			for( unsigned long step = 0; step < numSteps; ++step ) {
+				m_rateGroups[i].pendingMs -= stepMs;
+				runRateGroup(i, stepMs);
+			}
+			m_tickStats.fixedSteps += (unsigned int)numSteps;
+		}
+		else if( ++group.pendingTicks >= group.everyNth ) {
+			unsigned long groupDeltaMs = group.pendingMs;
+			group.pendingMs = 0;
+			group.pendingTicks = 0;
+			runRateGroup(i, groupDeltaMs);
+		}
+	}
+}//ProcessManager::runRateGroups
+
+// updates a rate group's processes once, the same way as the main thread ones
+void ProcessManager::runRateGroup( unsigned int index, unsigned long deltaMs ) {
+	for( unsigned int i = 0; i < m_rateGroups[index].processes.size(); ) {
+		ProcessArray& processes = m_rateGroups[index].processes;  // exit functions may add rate groups
+		Process* pProcess = processes[i];
+		if( pProcess->m_state == Process::RUNNING ) {
+			UpdateProcess(pProcess, deltaMs, m_isProfilingTypes);
+			if( pProcess->m_state == Process::RUNNING ) {
+				++i;
+				continue;
+			}
+		}
+
+		remove(processes, i);
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+}//ProcessManager::runRateGroup
+
+//---------------------------------------------------------------------------------------------------------------------
+// Updates the worker processes on the TBB pool and waits for them, with this thread helping out.  The processes only
+// get onUpdate() calls; their state changes are picked up by the sweep afterwards.
+//---------------------------------------------------------------------------------------------------------------------
+void ProcessManager::runWorkerProcesses( unsigned long deltaMs ) {
+	m_isRunningWorkers = true;
+	const bool isProfiling = m_isProfilingTypes;
+	tbb::task_group groupTasks;
+
+	for( auto it = m_processGroups.begin(); it != m_processGroups.end(); ++it ) {
+		const ProcessArray& processes = it->processes;
+		groupTasks.run([&processes, deltaMs, isProfiling]() {
+			for( auto processIt = processes.begin(); processIt != processes.end(); ++processIt ) {
+				if( (*processIt)->m_state == Process::RUNNING )
+					UpdateProcess(*processIt, deltaMs, isProfiling);
+			}
+		});
+	}
+
+	if( !m_parallelProcesses.empty() ) {
+		const ProcessArray& processes = m_parallelProcesses;
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, processes.size()), [&processes, deltaMs, isProfiling]( const tbb::blocked_range<size_t>& range ) {
+			for( size_t i = range.begin(); i != range.end(); ++i ) {
+				if( processes[i]->m_state == Process::RUNNING )
+					UpdateProcess(processes[i], deltaMs, isProfiling);
+			}
+		});
+	}
+
+	groupTasks.wait();
+	m_isRunningWorkers = false;
+}//ProcessManager::runWorkerProcesses
+
+//---------------------------------------------------------------------------------------------------------------------
+// Updates best-effort processes in turn, starting from where the last tick left off, until each has had an update or
+// time runs out.  Each one is owed the time since its own last update.  A process that stops running leaves a hole
+// that is closed up once the turn is over, so the order of the others, and with it the round-robin, stays the same.
+//---------------------------------------------------------------------------------------------------------------------
+void ProcessManager::runBestEffortProcesses( unsigned long long deadlineNs ) {
+	const unsigned int numTurns = (unsigned int)m_bestEffortProcesses.size();
+	const unsigned int first = (m_bestEffortCursor < numTurns) ? m_bestEffortCursor : 0;
+	unsigned int numRemoved = 0;
+	unsigned int turn = 0;
+	for( ; turn < numTurns; ++turn ) {
+		if( turn > 0 && deadlineNs != PROCESSMANAGER_NO_DEADLINE && Clock::nowNs() >= deadlineNs )
+			break;
+
+		unsigned int i = (first + turn) % numTurns;
+		Process* pProcess = m_bestEffortProcesses[i];
+		if( pProcess->m_state == Process::RUNNING ) {
+			UpdateProcess(pProcess, (unsigned long)(m_timeMs - pProcess->m_lastUpdateMs), m_isProfilingTypes);
+			pProcess->m_lastUpdateMs = m_timeMs;
+			if( pProcess->m_state == Process::RUNNING )
+				continue;
+		}
+
+		m_bestEffortProcesses[i] = NULL;
+		++numRemoved;
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+
+	// close up the holes; processes placed during the turn were appended and are kept too
+	unsigned int next = (numTurns > 0) ? (first + turn) % numTurns : 0;
+	if( numRemoved > 0 ) {
+		unsigned int numKept = 0;
+		unsigned int nextKept = 0;
+		for( unsigned int i = 0; i < m_bestEffortProcesses.size(); ++i ) {
+			if( i == next )
+				nextKept = numKept;
+			if( m_bestEffortProcesses[i] )
+				m_bestEffortProcesses[numKept++] = m_bestEffortProcesses[i];
+		}
+		m_bestEffortProcesses.resize(numKept);
+		next = nextKept;
+	}
+
+	m_bestEffortCursor = (next < m_bestEffortProcesses.size()) ? next : 0;
+	m_tickStats.deferred = numTurns - turn;
+	if( m_tickStats.deferred > 0 )
+		m_tickStats.maxLagMs = (unsigned long)(m_timeMs - m_bestEffortProcesses[m_bestEffortCursor]->m_lastUpdateMs);
+}//ProcessManager::runBestEffortProcesses
+
+// moves the processes that stopped running out of a worker array
+void ProcessManager::sweep( ProcessArray& processes ) {
+	for( unsigned int i = 0; i < processes.size(); ) {
+		Process* pProcess = processes[i];
+		if( pProcess->m_state == Process::RUNNING ) {
+			++i;
+			continue;
+		}
+
+		remove(processes, i);
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+}//ProcessManager::sweep
+
+// Same as sweep() for a serialized group.  Exit functions and wakes may add groups, which moves the groups around, so
+// the group's array is looked up again for each process.
+void ProcessManager::sweepGroup( unsigned int index ) {
+	for( unsigned int i = 0; i < m_processGroups[index].processes.size(); ) {
+		ProcessArray& processes = m_processGroups[index].processes;
+		Process* pProcess = processes[i];
+		if( pProcess->m_state == Process::RUNNING ) {
+			++i;
+			continue;
+		}
+
+		remove(processes, i);
+		if( pProcess->isDead() )
+			finish(pProcess);
+		else
+			place(pProcess);
+	}
+}//ProcessManager::sweepGroup
+
 WeakProcessPtr ProcessManager::attachProcess( StrongProcessPtr pProcess ) {
-	m_processList.push_front(pProcess);
+	GEN_ASSERT(!m_isRunningWorkers);
+	if( !pProcess ) {
+		GEN_ERROR("Invalid process in attachProcess()");
+		return WeakProcessPtr();
+	}
+	if( pProcess->m_managerSlot != Process::kNOT_ATTACHED ) {
+		GEN_WARNING("Attempting to attach a process that is already attached");
+		return WeakProcessPtr(pProcess);
+	}
+
+	allocateSlot(pProcess);
+	Append(m_newProcesses, pProcess.get());
 
 	return WeakProcessPtr(pProcess);
 }//ProcessManager::attachProcess
 
-void ProcessManager::clearAllProcesses() {
-	m_processList.clear();
-}//ProcessManager::clearAllProcesses
+WeakProcessPtr ProcessManager::attachAfter( StrongProcessPtr pProcess, StrongProcessPtr pPrerequisite ) {
+	std::vector<StrongProcessPtr> prerequisites(1, pPrerequisite);
+	return attachAfter(pProcess, prerequisites);
+}//ProcessManager::attachAfter
+
+//---------------------------------------------------------------------------------------------------------------------
+// The process is given a slot right away, so it has a handle and is aborted with everything else, but it's kept out of
+// the arrays until its last prerequisite succeeds.  Nothing is attached unless every prerequisite can be waited for.
+//---------------------------------------------------------------------------------------------------------------------
+WeakProcessPtr ProcessManager::attachAfter( StrongProcessPtr pProcess, const std::vector<StrongProcessPtr>& prerequisites ) {
+	GEN_ASSERT(!m_isRunningWorkers);
+	if( !pProcess ) {
+		GEN_ERROR("Invalid process in attachAfter()");
+		return WeakProcessPtr();
+	}
+	if( pProcess->m_managerSlot != Process::kNOT_ATTACHED ) {
+		GEN_WARNING("Attempting to attach a process that is already attached");
+		return WeakProcessPtr(pProcess);
+	}
+	for( auto it = prerequisites.begin(); it != prerequisites.end(); ++it ) {
+		const StrongProcessPtr& pPrerequisite = *it;
+		bool isValid = (pPrerequisite && pPrerequisite != pProcess);
+		if( isValid && pPrerequisite->m_pManager != this ) {
+			if( pPrerequisite->m_pManager )
+				isValid = false;  // attached to another process mgr
+			else
+				isValid = (pPrerequisite->m_state == Process::UNINITIALIZED || pPrerequisite->m_state == Process::SUCCEEDED);
+		}
+		if( !isValid ) {
+			GEN_WARNING("Attempting to attach a process after one that can't succeed under this process mgr");
+			return WeakProcessPtr();
+		}
+	}
+
+	unsigned int slot = allocateSlot(pProcess);
+	for( auto it = prerequisites.begin(); it != prerequisites.end(); ++it ) {
+		Process* pPrerequisite = it->get();
+		if( !pPrerequisite->m_pManager ) {
+			if( pPrerequisite->m_state == Process::SUCCEEDED )
+				continue;
+			attachProcess(*it);
+		}
+		Append(m_slots[pPrerequisite->m_managerSlot].dependents, getHandle(*pProcess));
+		++pProcess->m_numPrerequisites;
+	}
+
+	if( pProcess->m_numPrerequisites > 0 ) {
+		m_slots[slot].isParked = true;
+		++m_numBlocked;
+	}
+	else {
+		Append(m_newProcesses, pProcess.get());
+	}
+
+	return WeakProcessPtr(pProcess);
+}//ProcessManager::attachAfter
+
+unsigned int ProcessManager::allocateSlot( const StrongProcessPtr& pProcess ) {
+	unsigned int slot = m_freeSlot;
+	if( slot != Process::kNOT_ATTACHED ) {
+		m_freeSlot = m_slots[slot].nextFree;
+	}
+	else {
+		slot = (unsigned int)m_slots.size();
+		Append(m_slots, ProcessSlot());
+		m_slots[slot].generation = 0;
+		m_slots[slot].sleepSerial = 0;
+		m_slots[slot].isParked = false;
+	}
+
+	m_slots[slot].pProcess = pProcess;
+	pProcess->m_pManager = this;
+	pProcess->m_managerSlot = slot;
+	pProcess->m_numPrerequisites = 0;
+	pProcess->m_pTypeCounters = getTypeCounters(*pProcess);
+	return slot;
+}//ProcessManager::allocateSlot
 
 //---------------------------------------------------------------------------------------------------------------------
 // Aborts all processes.  If immediate == true, it immediately calls each ones OnAbort() function and destroys all
-// the processes.
+// the processes.  That can't be done from inside a process's update, so there the processes are only marked and the
+// rest is left to the tick.
 //---------------------------------------------------------------------------------------------------------------------
 void ProcessManager::abortAllProcesses( bool immediate ) {
-	ProcessList::iterator it = m_processList.begin();
-	while( it != m_processList.end() ) {
-		ProcessList::iterator tempIt = it;
-		++it;
+	if( immediate && m_isUpdating ) {
+		GEN_WARNING("Can't destroy processes from inside updateProcesses(); they will be aborted by the tick instead");
+		immediate = false;
+	}
+
+	// the sleeping, paused and blocked processes that are out of the arrays; the others are aborted with the arrays
+	for( unsigned int slot = 0; slot < m_slots.size(); ++slot ) {
+		if( !m_slots[slot].isParked )
+			continue;
+
+		Process* pProcess = m_slots[slot].pProcess.get();
+		unpark(*pProcess, pProcess->m_state);
+		pProcess->setState(Process::ABORTED);
+		if( immediate ) {
+			pProcess->onAbort();
+			release(pProcess);
+		}
+		else {
+			place(pProcess);
+		}
+	}
+
+	abort(m_runningProcesses, immediate);
+	abort(m_parallelProcesses, immediate);
+	abort(m_bestEffortProcesses, immediate);
+	for( auto it = m_rateGroups.begin(); it != m_rateGroups.end(); ++it )
+		abort(it->processes, immediate);
+	for( auto it = m_processGroups.begin(); it != m_processGroups.end(); ++it )
+		abort(it->processes, immediate);
+}//ProcessManager::abortAllProcesses
 
-		StrongProcessPtr pProcess = *tempIt;
-		if( pProcess->isAlive() ) {
+void ProcessManager::abort( ProcessArray& processes, bool immediate ) {
+	for( unsigned int i = 0; i < processes.size(); ) {
+		Process* pProcess = processes[i];
+		if( pProcess && pProcess->isAlive() ) {  // NULL in the middle of the best-effort turn
 			pProcess->setState(Process::ABORTED);
 			if( immediate ) {
 				pProcess->onAbort();
-				m_processList.erase(tempIt);
+				remove(processes, i);
+				release(pProcess);
+				continue;
 			}
 		}
+		++i;
 	}
-}//ProcessManager::abortAllProcesses
+}//ProcessManager::abort
+
+unsigned int ProcessManager::getRunningCount() const {
+	size_t count = m_runningProcesses.size() + m_parallelProcesses.size() + m_bestEffortProcesses.size();
+	for( auto it = m_processGroups.begin(); it != m_processGroups.end(); ++it )
+		count += it->processes.size();
+	for( auto it = m_rateGroups.begin(); it != m_rateGroups.end(); ++it )
+		count += it->processes.size();
+	return (unsigned int)count;
+}//ProcessManager::getRunningCount
+
+ProcessRateGroup ProcessManager::addFixedStepGroup( unsigned long stepMs, unsigned int maxStepsPerTick ) {
+	if( stepMs == 0 || maxStepsPerTick == 0 ) {
+		GEN_ERROR("Invalid fixed step rate group");
+		return 0;
+	}
+
+	RateGroup group;
+	group.kind = RATE_GROUP_FIXED_STEP;
+	group.stepMs = stepMs;
+	group.maxSteps = maxStepsPerTick;
+	group.everyNth = 1;
+	group.pendingMs = 0;
+	group.pendingTicks = 0;
+	m_rateGroups.push_back(group);
+	return (ProcessRateGroup)m_rateGroups.size();
+}//ProcessManager::addFixedStepGroup
+
+ProcessRateGroup ProcessManager::addEveryNthGroup( unsigned int everyNth ) {
+	if( everyNth == 0 ) {
+		GEN_ERROR("Invalid every-Nth rate group");
+		return 0;
+	}
+
+	RateGroup group;
+	group.kind = RATE_GROUP_EVERY_NTH;
+	group.stepMs = 0;
+	group.maxSteps = 0;
+	group.everyNth = everyNth;
+	group.pendingMs = 0;
+	group.pendingTicks = 0;
+	m_rateGroups.push_back(group);
+	return (ProcessRateGroup)m_rateGroups.size();
+}//ProcessManager::addEveryNthGroup
+
+//---------------------------------------------------------------------------------------------------------------------
+// The state the group's processes were in before their last update is at alpha 0 and the state they're in now at 1,
+// with the time as it is now lying somewhere in between, so blending by alpha shows them where they'd be at the
+// current time, one update late.
+//---------------------------------------------------------------------------------------------------------------------
+float ProcessManager::getInterpolationAlpha( ProcessRateGroup group ) const {
+	if( group == 0 || group > m_rateGroups.size() )
+		return 1.0f;
+
+	const RateGroup& rateGroup = m_rateGroups[group - 1];
+	if( rateGroup.kind == RATE_GROUP_FIXED_STEP )
+		return (float)rateGroup.pendingMs / (float)rateGroup.stepMs;
+	return (float)rateGroup.pendingTicks / (float)rateGroup.everyNth;
+}//ProcessManager::getInterpolationAlpha
+
+ProcessHandle ProcessManager::getHandle( const Process& process ) const {
+	unsigned int slot = process.m_managerSlot;
+	if( slot >= m_slots.size() || m_slots[slot].pProcess.get() != &process )
+		return 0;
+	return ((ProcessHandle)m_slots[slot].generation << 32) | (ProcessHandle)(slot + 1);
+}//ProcessManager::getHandle
+
+StrongProcessPtr ProcessManager::getProcess( ProcessHandle handle ) const {
+	unsigned int slot = (unsigned int)(handle & 0xffffffff) - 1;
+	if( handle == 0 || slot >= m_slots.size() || m_slots[slot].generation != (unsigned int)(handle >> 32) )
+		return StrongProcessPtr();
+	return m_slots[slot].pProcess;
+}//ProcessManager::getProcess
+
+//---------------------------------------------------------------------------------------------------------------------
+// Puts a running process to sleep.  It stays in its array until the tick comes across it, so a process that is woken
+// again before then never leaves it.
+//---------------------------------------------------------------------------------------------------------------------
+bool ProcessManager::beginSleep( Process& process ) {
+	GEN_ASSERT(!m_isRunningWorkers);
+	if( process.m_pManager != this ) {
+		GEN_ERROR("Attempting to put a process to sleep that isn't attached to this process mgr");
+		return false;
+	}
+	if( process.m_state != Process::RUNNING ) {
+		GEN_WARNING("Attempting to put a process to sleep that isn't running");
+		return false;
+	}
+
+	process.m_state = Process::SLEEPING;
+	++m_slots[process.m_managerSlot].sleepSerial;
+	return true;
+}//ProcessManager::beginSleep
+
+bool ProcessManager::sleep( Process& process, unsigned long durationMs ) {
+	if( !beginSleep(process) )
+		return false;
+
+	ProcessWaiter waiter;
+	waiter.slot = process.m_managerSlot;
+	waiter.sleepSerial = m_slots[process.m_managerSlot].sleepSerial;
+	addTimer(m_timeMs + durationMs, waiter);
+	return true;
+}//ProcessManager::sleep
+
+bool ProcessManager::sleepUntilWoken( Process& process ) {
+	return beginSleep(process);
+}//ProcessManager::sleepUntilWoken
+
+//---------------------------------------------------------------------------------------------------------------------
+// Whichever comes first of the signal and the timeout wakes the process; the other one is then stale and ignored.
+//---------------------------------------------------------------------------------------------------------------------
+bool ProcessManager::sleepUntilSignal( Process& process, ProcessSignal signal, unsigned long timeoutMs ) {
+	if( !beginSleep(process) )
+		return false;
+
+	ProcessWaiter waiter;
+	waiter.slot = process.m_managerSlot;
+	waiter.sleepSerial = m_slots[process.m_managerSlot].sleepSerial;
+	auto findIt = m_signalWaiters.find(signal);
+	if( findIt == m_signalWaiters.end() ) {
+		MemoryPool::countHeapAllocation();  // the map entry
+		findIt = m_signalWaiters.insert(std::make_pair(signal, std::vector<ProcessWaiter>())).first;
+	}
+	appendWaiter(findIt->second, waiter);
+
+	if( timeoutMs != 0 )
+		addTimer(m_timeMs + timeoutMs, waiter);
+	return true;
+}//ProcessManager::sleepUntilSignal
+
+unsigned int ProcessManager::signal( ProcessSignal signal ) {
+	GEN_ASSERT(!m_isRunningWorkers);
+	auto findIt = m_signalWaiters.find(signal);
+	if( findIt == m_signalWaiters.end() )
+		return 0;
+
+	unsigned int numWoken = 0;
+	std::vector<ProcessWaiter>& waiters = findIt->second;
+	for( unsigned int i = 0; i < waiters.size(); ++i ) {
+		if( wake(waiters[i]) )
+			++numWoken;
+	}
+	waiters.clear();  // the entry and its capacity are kept for the next wait
+	return numWoken;
+}//ProcessManager::signal
+
+bool ProcessManager::sleepUntilDone( Process& process, const Process& target ) {
+	if( target.m_pManager != this || &target == &process ) {
+		GEN_WARNING("Attempting to wait for a process that isn't attached to this process mgr");
+		return false;
+	}
+	if( !beginSleep(process) )
+		return false;
+
+	ProcessWaiter waiter;
+	waiter.slot = process.m_managerSlot;
+	waiter.sleepSerial = m_slots[process.m_managerSlot].sleepSerial;
+	appendWaiter(m_slots[target.m_managerSlot].waiters, waiter);
+	return true;
+}//ProcessManager::sleepUntilDone
+
+bool ProcessManager::wake( Process& process ) {
+	GEN_ASSERT(!m_isRunningWorkers);
+	if( process.m_pManager != this || process.m_state != Process::SLEEPING )
+		return false;
+
+	process.m_state = Process::RUNNING;
+	requeue(process, Process::SLEEPING);
+	return true;
+}//ProcessManager::wake
+
+bool ProcessManager::wake( const ProcessWaiter& waiter ) {
+	const ProcessSlot& processSlot = m_slots[waiter.slot];
+	if( !processSlot.pProcess || processSlot.sleepSerial != waiter.sleepSerial )
+		return false;
+	return wake(*processSlot.pProcess);
+}//ProcessManager::wake
+
+// false once the sleep the waiter was for has ended, however it ended
+bool ProcessManager::isWaiting( const ProcessWaiter& waiter ) const {
+	const ProcessSlot& processSlot = m_slots[waiter.slot];
+	return processSlot.pProcess && processSlot.sleepSerial == waiter.sleepSerial && processSlot.pProcess->m_state == Process::SLEEPING;
+}//ProcessManager::isWaiting
+
+//---------------------------------------------------------------------------------------------------------------------
+// Adds to a signal's or a process's list of waiters.  Waiters that timed out or were woken some other way stay in the
+// list until it's walked, which may be never, so when the list is full they are compacted out first.  If that doesn't
+// free at least half of it, it grows as well, so the list stays under twice the live waiters and compacting is
+// amortized over the appends.
+//---------------------------------------------------------------------------------------------------------------------
+void ProcessManager::appendWaiter( std::vector<ProcessWaiter>& waiters, const ProcessWaiter& waiter ) {
+	if( !waiters.empty() && waiters.size() == waiters.capacity() ) {
+		unsigned int numWaiting = 0;
+		for( unsigned int i = 0; i < waiters.size(); ++i ) {
+			if( isWaiting(waiters[i]) )
+				waiters[numWaiting++] = waiters[i];
+		}
+		waiters.resize(numWaiting);
+
+		if( numWaiting * 2 > waiters.capacity() ) {
+			MemoryPool::countHeapAllocation();
+			waiters.reserve(waiters.capacity() * 2);
+		}
+	}
+	Append(waiters, waiter);
+}//ProcessManager::appendWaiter
+
+void ProcessManager::addTimer( unsigned long long wakeMs, const ProcessWaiter& waiter ) {
+	ProcessTimer timer;
+	timer.wakeMs = wakeMs;
+	timer.waiter = waiter;
+	Append(m_timers, timer);
+	std::push_heap(m_timers.begin(), m_timers.end(), ProcessTimerLater());
+}//ProcessManager::addTimer
+
+void ProcessManager::wakeTimers() {
+	while( !m_timers.empty() && m_timers.front().wakeMs <= m_timeMs ) {
+		ProcessWaiter waiter = m_timers.front().waiter;
+		std::pop_heap(m_timers.begin(), m_timers.end(), ProcessTimerLater());
+		m_timers.pop_back();
+		if( wake(waiter) )
+			++m_tickStats.woken;
+	}
+}//ProcessManager::wakeTimers
+
+// Called when a sleeping or paused process changes state.  If the tick has already set it aside, it goes back in the
+// array for its new state; otherwise the tick will see the change when it comes across it.
+void ProcessManager::requeue( Process& process, Process::State prevState ) {
+	GEN_ASSERT(!m_isRunningWorkers);
+	if( !m_slots[process.m_managerSlot].isParked )
+		return;
+
+	unpark(process, prevState);
+	place(&process);
+}//ProcessManager::requeue
+
+void ProcessManager::unpark( Process& process, Process::State parkedState ) {
+	m_slots[process.m_managerSlot].isParked = false;
+	if( parkedState == Process::PAUSED )
+		--m_numPaused;
+	else if( parkedState == Process::SLEEPING )
+		--m_numSleeping;
+	else
+		--m_numBlocked;
+}//ProcessManager::unpark
+
+// Puts a process that is still attached in the array for its state, or sets it aside if it's asleep or paused.  Only
+// the running arrays are updated.
+void ProcessManager::place( Process* pProcess ) {
+	switch( pProcess->m_state ) {
+		case Process::UNINITIALIZED :
+			Append(m_newProcesses, pProcess);
+			break;
+
+		case Process::RUNNING :
+			if( pProcess->m_rateGroup != 0 && pProcess->m_rateGroup <= m_rateGroups.size() ) {  // an unknown group falls back to the default
+				Append(m_rateGroups[pProcess->m_rateGroup - 1].processes, pProcess);
+			}
+			else if( pProcess->m_priority == PROCESS_PRIORITY_BEST_EFFORT ) {
+				pProcess->m_lastUpdateMs = m_tickBaseMs;  // owed this tick's time, like any process that starts running
+				Append(m_bestEffortProcesses, pProcess);
+			}
+			else if( pProcess->m_concurrency == PROCESS_ANY_THREAD ) {
+				Append(m_parallelProcesses, pProcess);
+			}
+			else if( pProcess->m_concurrency == PROCESS_SERIALIZED ) {
+				auto indexIt = m_groupIndices.find(pProcess->m_dataKey);
+				if( indexIt == m_groupIndices.end() ) {
+					MemoryPool::countHeapAllocation();  // the map entry
+					indexIt = m_groupIndices.insert(std::make_pair(pProcess->m_dataKey, (unsigned int)m_processGroups.size())).first;
+					Append(m_processGroups, ProcessGroup());
+					m_processGroups.back().dataKey = pProcess->m_dataKey;
+				}
+				Append(m_processGroups[indexIt->second].processes, pProcess);
+			}
+			else {
+				Append(m_runningProcesses, pProcess);
+			}
+			break;
+
+		case Process::SLEEPING :
+			m_slots[pProcess->m_managerSlot].isParked = true;
+			++m_numSleeping;
+			break;
+
+		case Process::PAUSED :
+			m_slots[pProcess->m_managerSlot].isParked = true;
+			++m_numPaused;
+			break;
+
+		default:
+			Append(m_endedProcesses, pProcess);
+			break;
+	}
+}//ProcessManager::place
+
+void ProcessManager::remove( ProcessArray& processes, unsigned int index ) {
+	processes[index] = processes.back();
+	processes.pop_back();
+}//ProcessManager::remove
+
+// runs the appropriate exit function for a dead process, attaches its child if it succeeded and lets it go
+void ProcessManager::finish( Process* pProcess ) {
+	switch( pProcess->m_state ) {
+		case Process::SUCCEEDED :
+		{
+			pProcess->onSuccess();
+			StrongProcessPtr pChild = pProcess->removeChild();
+			if( pChild ) {
+				attachProcess(pChild);
+				++m_tickStats.spawned;
+			}
+			else {
+				++m_tickStats.succeeded;  // only counts if the whole chain completed
+			}
+			break;
+		}
+
+		case Process::FAILED :
+		{
+			pProcess->onFail();
+			++m_tickStats.failed;
+			break;
+		}
+
+		case Process::ABORTED :
+		{
+			pProcess->onAbort();
+			++m_tickStats.aborted;
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+
+	release(pProcess);
+}//ProcessManager::finish
+
+// Frees the process's slot, which destroys the process unless someone else still holds on to it.  The processes waiting
+// for it to end are woken first, and the ones attached after it are started or aborted.
+void ProcessManager::release( Process* pProcess ) {
+	unsigned int slot = pProcess->m_managerSlot;
+	for( unsigned int i = 0; i < m_slots[slot].waiters.size(); ++i )
+		wake(m_slots[slot].waiters[i]);
+	m_slots[slot].waiters.clear();
+	if( !m_slots[slot].dependents.empty() )
+		releaseDependents(m_slots[slot], (pProcess->m_state == Process::SUCCEEDED));
+
+	pProcess->m_pManager = NULL;
+	pProcess->m_managerSlot = Process::kNOT_ATTACHED;
+
+	ProcessSlot& processSlot = m_slots[slot];
+	++processSlot.generation;
+	processSlot.nextFree = m_freeSlot;
+	m_freeSlot = slot;
+	processSlot.pProcess.reset();
+}//ProcessManager::release
+
+//---------------------------------------------------------------------------------------------------------------------
+// A dependent whose last prerequisite succeeded is attached like a new process.  One whose prerequisite didn't succeed
+// is aborted and left for the tick to finish, which aborts its own dependents in turn.
+//---------------------------------------------------------------------------------------------------------------------
+void ProcessManager::releaseDependents( ProcessSlot& processSlot, bool hasSucceeded ) {
+	for( auto it = processSlot.dependents.begin(); it != processSlot.dependents.end(); ++it ) {
+		StrongProcessPtr pDependent = getProcess(*it);
+		if( !pDependent || pDependent->m_state != Process::UNINITIALIZED || pDependent->m_numPrerequisites == 0 )
+			continue;  // already aborted
+
+		if( hasSucceeded && --pDependent->m_numPrerequisites > 0 )
+			continue;
+
+		unpark(*pDependent, Process::UNINITIALIZED);
+		if( !hasSucceeded ) {
+			pDependent->m_numPrerequisites = 0;
+			pDependent->setState(Process::ABORTED);
+		}
+		place(pDependent.get());
+	}
+	processSlot.dependents.clear();
+}//ProcessManager::releaseDependents
+
+// a process's onUpdate(), timed for its class when profiling is on
+void ProcessManager::UpdateProcess( Process* pProcess, unsigned long deltaMs, bool isProfiling ) {
+	if( !isProfiling ) {
+		pProcess->onUpdate(deltaMs);
+		return;
+	}
+
+	unsigned long long startNs = Clock::nowNs();
+	pProcess->onUpdate(deltaMs);
+	pProcess->m_pTypeCounters->record(Clock::nowNs() - startNs);
+}//ProcessManager::UpdateProcess
+
+ProcessTypeCounters* ProcessManager::getTypeCounters( const Process& process ) {
+	std::type_index type(typeid(process));
+	auto findIt = m_typeCounterMap.find(type);
+	if( findIt != m_typeCounterMap.end() )
+		return findIt->second;
+
+	m_typeCounters.push_back(std::unique_ptr<ProcessTypeCounters>(new ProcessTypeCounters(TypeName(typeid(process)))));
+	m_typeCounterMap[type] = m_typeCounters.back().get();
+	return m_typeCounters.back().get();
+}//ProcessManager::getTypeCounters
+
+void ProcessManager::updateTypeTickStats() {
+	for( auto it = m_typeCounters.begin(); it != m_typeCounters.end(); ++it ) {
+		ProcessTypeCounters& counters = **it;
+		unsigned long long updates = counters.updates.load(std::memory_order_relaxed);
+		unsigned long long totalNs = counters.totalNs.load(std::memory_order_relaxed);
+		counters.lastTickUpdates = updates - counters.markUpdates;
+		counters.lastTickNs = totalNs - counters.markNs;
+		counters.markUpdates = updates;
+		counters.markNs = totalNs;
+	}
+}//ProcessManager::updateTypeTickStats
+
+void ProcessManager::getTypeStats( std::vector<ProcessTypeStats>& outStats ) const {
+	outStats.clear();
+	for( auto it = m_typeCounters.begin(); it != m_typeCounters.end(); ++it ) {
+		const ProcessTypeCounters& counters = **it;
+		ProcessTypeStats stats;
+		stats.name = counters.name;
+		stats.updates = counters.updates.load(std::memory_order_relaxed);
+		stats.totalNs = counters.totalNs.load(std::memory_order_relaxed);
+		stats.maxNs = counters.maxNs.load(std::memory_order_relaxed);
+		stats.lastTickUpdates = counters.lastTickUpdates;
+		stats.lastTickNs = counters.lastTickNs;
+		outStats.push_back(stats);
+	}
+}//ProcessManager::getTypeStats
+
+void ProcessManager::resetTypeStats() {
+	for( auto it = m_typeCounters.begin(); it != m_typeCounters.end(); ++it ) {
+		ProcessTypeCounters& counters = **it;
+		counters.updates.store(0, std::memory_order_relaxed);
+		counters.totalNs.store(0, std::memory_order_relaxed);
+		counters.maxNs.store(0, std::memory_order_relaxed);
+		counters.lastTickUpdates = 0;
+		counters.lastTickNs = 0;
+		counters.markUpdates = 0;
+		counters.markNs = 0;
+	}
+}//ProcessManager::resetTypeStats
+
+void ProcessManager::clearAllProcesses() {
+	for( auto it = m_slots.begin(); it != m_slots.end(); ++it ) {
+		if( it->pProcess ) {
+			it->pProcess->m_pManager = NULL;
+			it->pProcess->m_managerSlot = Process::kNOT_ATTACHED;
+		}
+	}
+
+	m_newProcesses.clear();
+	m_runningProcesses.clear();
+	m_parallelProcesses.clear();
+	m_bestEffortProcesses.clear();
+	m_bestEffortCursor = 0;
+	for( auto it = m_rateGroups.begin(); it != m_rateGroups.end(); ++it )
+		it->processes.clear();
+	m_processGroups.clear();
+	m_groupIndices.clear();
+	m_endedProcesses.clear();
+	m_slots.clear();
+	m_freeSlot = Process::kNOT_ATTACHED;
+	m_timers.clear();
+	m_signalWaiters.clear();
+	m_numSleeping = 0;
+	m_numPaused = 0;
+	m_numBlocked = 0;
+}//ProcessManager::clearAllProcesses
 
 }
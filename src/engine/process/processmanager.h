@@ -1,27 +1,272 @@
 #ifndef PROCESS_MANAGER_H
 #define PROCESS_MANAGER_H
 
-#include <list>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
 
 #include "process.h"
 
 namespace genesis {
 
+typedef unsigned long long ProcessHandle;  // 0 is never a valid handle
+typedef unsigned long ProcessSignal;  // any value the code raising it and the processes waiting for it agree on
+
+// What the last call to updateProcesses() did
+struct ProcessTickStats {
+	unsigned int		succeeded;  // process chains that completed; a process whose child took over isn't counted
+	unsigned int		failed;
+	unsigned int		aborted;
+	unsigned int		spawned;  // children attached because their parent succeeded
+	unsigned int		running;  // processes left running after the tick
+	unsigned int		sleeping;  // processes asleep after the tick; the tick doesn't touch them
+	unsigned int		paused;  // nor these
+	unsigned int		blocked;  // nor processes waiting for their prerequisites
+	unsigned int		woken;  // sleeping processes woken by their timer during the tick
+	unsigned int		deferred;  // best-effort processes that didn't get an update because the budget ran out
+	unsigned long		maxLagMs;  // how long it has been since the next best-effort process in line was updated
+	unsigned int		fixedSteps;  // steps taken by the fixed step rate groups, summed over the groups
+	unsigned long		droppedMs;  // time the fixed step rate groups let go of because they hit their catch-up limit
+	unsigned long long	tickNs;  // how long updateProcesses() took
+	unsigned long		heapAllocations;  // memory pool growth and process mgr array growth; 0 once the workload is steady
+};
+
+// onUpdate() timing for one process class, while type profiling is on
+struct ProcessTypeStats {
+	std::string			name;
+	unsigned long long	updates;  // since the stats were last reset
+	unsigned long long	totalNs;
+	unsigned long long	maxNs;
+	unsigned long long	lastTickUpdates;
+	unsigned long long	lastTickNs;
+};
+
+// Workers update them too, so the running totals are relaxed atomics
+struct ProcessTypeCounters {
+	std::string							name;
+	std::atomic<unsigned long long>		updates;
+	std::atomic<unsigned long long>		totalNs;
+	std::atomic<unsigned long long>		maxNs;
+	unsigned long long					lastTickUpdates;  // these are only touched by the thread running the tick
+	unsigned long long					lastTickNs;
+	unsigned long long					markUpdates;
+	unsigned long long					markNs;
+
+	explicit ProcessTypeCounters( const std::string& typeName );
+
+	void record( unsigned long long ns ) {
+		updates.fetch_add(1, std::memory_order_relaxed);
+		totalNs.fetch_add(ns, std::memory_order_relaxed);
+		unsigned long long prevMax = maxNs.load(std::memory_order_relaxed);
+		while( ns > prevMax && !maxNs.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed) ) {}
+	}
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// ProcessManager class
+//
+// Owns the attached processes in a table of slots, which is what handles refer to, and keeps a raw pointer to each in
+// one of three contiguous arrays by state: processes waiting for onInit(), running ones and ones that ended outside the
+// tick and are waiting for it to run their exit functions.  The update tick only walks the running array, without
+// touching any reference counts, and a process that stops running is swap-removed from it, so the cost of a tick
+// follows the number of running processes and not how they got there.
+//
+// Processes that are paused or ended from outside their own onUpdate() are taken out of the running array when the
+// tick comes across them.  Paused processes are then set aside in their slot, like sleeping ones, and unPause() puts
+// them straight back.
+//
+// Running processes that declared themselves parallel-safe with Process::setConcurrency() are kept apart from the main
+// thread ones.  Once the main thread processes have been updated, the any-thread ones are split up with parallel_for
+// on the TBB work-stealing pool, and each group of processes sharing a data key becomes one task that updates them in
+// turn.  Everything that follows an update, exit functions and attaching children included, happens afterwards on the
+// calling thread, in array order, so it is as deterministic as a serial tick.
+//
+// Besides the single chain of children a process can have, processes can be joined into a graph with attachAfter().
+// A process attached after others is held back, without an update or even onInit(), until every one of them has
+// succeeded, and is aborted as soon as one of them fails or is aborted.  Attaching several processes after the same
+// one forks there, and attaching one after several joins them:
+//
+//		pm.attachAfter(pDecodeAudio, pLoadPackage);  // fork: both decoders start once the package is loaded
+//		pm.attachAfter(pDecodeTextures, pLoadPackage);
+//		pm.attachAfter(pStartLevel, { pDecodeAudio, pDecodeTextures });  // join
+//
+// Processes whose prerequisites are met start in the next tick, all together, so independent branches run side by
+// side, on workers too if they declared themselves parallel-safe.
+//
+// By default every running process is updated once per tick with the tick's deltaMs.  Processes that need another rate
+// can be put in a rate group: a fixed step group updates its processes in steps of a fixed deltaMs, as many as the
+// time since its last step allows, and an every-Nth group updates them every Nth tick with the time since then.  Each
+// group keeps its running processes in an array of its own and updates them all before moving on to the next step or
+// group.  The groups run in the order they were made, ahead of the variable rate processes.  getInterpolationAlpha()
+// tells how far the time has moved on from a group's last update towards its next one, for blending what's drawn.
+//
+// updateProcesses() can be given a time budget, like EventManager::update().  Every-tick processes are always updated;
+// best-effort ones share what is left of the budget, taking turns from where the last tick stopped, and at least one of
+// them is updated every tick so they can't be starved completely.  The clock is read after each best-effort update.
+//
+// Every tick fills in a ProcessTickStats.  Timing each onUpdate() would cost as much as a cheap update itself, so the
+// per class times are only gathered while setTypeProfiling() is on; the class of each process is looked up once, when
+// it's attached.
+//
+// A running process can be put to sleep for a while, until it is woken, until a signal is raised, or until another
+// process ends.  A sleeping process isn't in any of the arrays, so it costs the tick nothing; timed sleeps wait in a
+// heap ordered by wake time, on a clock that advances by the deltaMs passed to each tick, and a tick only pops the
+// timers that are due.  Sleeping, waking and signals must happen on the thread running the tick.
+//---------------------------------------------------------------------------------------------------------------------
 class ProcessManager {
-	typedef std::list<StrongProcessPtr> ProcessList;
+	friend class Process;
+
+	// a sleeping process to wake; it's skipped if the process has woken up or gone to sleep again since
+	struct ProcessWaiter {
+		unsigned int		slot;
+		unsigned int		sleepSerial;
+	};
+
+	struct ProcessSlot {
+		StrongProcessPtr	pProcess;  // NULL while the slot is free
+		unsigned int		generation;  // bumped whenever the slot is freed, so old handles stop matching
+		unsigned int		nextFree;
+		unsigned int		sleepSerial;  // bumped by every sleep, so what was waiting on an earlier one is ignored
+		bool				isParked;  // asleep, paused or blocked, and out of every array
+		std::vector<ProcessWaiter>	waiters;  // processes sleeping until this one ends
+		std::vector<ProcessHandle>	dependents;  // processes attached after this one
+	};
+
+	struct ProcessTimer {
+		unsigned long long	wakeMs;
+		ProcessWaiter		waiter;
+	};
+
+	// orders m_timers as a min-heap on the wake time
+	struct ProcessTimerLater {
+		bool operator()( const ProcessTimer& a, const ProcessTimer& b ) const { return (a.wakeMs > b.wakeMs); }
+	};
 
-	ProcessList		m_processList;
+	typedef std::vector<Process*> ProcessArray;
+
+	enum RateGroupKind {
+		RATE_GROUP_FIXED_STEP,
+		RATE_GROUP_EVERY_NTH,
+	};
+
+	struct RateGroup {
+		RateGroupKind		kind;
+		unsigned long		stepMs;  // fixed step only
+		unsigned int		maxSteps;  // fixed step only: the most it will take in one tick
+		unsigned int		everyNth;  // every-Nth only
+		unsigned long		pendingMs;  // time since the group was last updated or stepped
+		unsigned int		pendingTicks;  // every-Nth only: ticks since the group was last updated
+		ProcessArray		processes;  // running only
+	};
+
+	// the running PROCESS_SERIALIZED processes with one data key
+	struct ProcessGroup {
+		unsigned long		dataKey;
+		ProcessArray		processes;
+	};
+
+	std::vector<ProcessSlot>	m_slots;
+	unsigned int		m_freeSlot;
+	ProcessArray		m_newProcesses;
+	ProcessArray		m_runningProcesses;  // main thread only
+	ProcessArray		m_parallelProcesses;  // PROCESS_ANY_THREAD
+	ProcessArray		m_bestEffortProcesses;  // PROCESS_PRIORITY_BEST_EFFORT, on the main thread
+	unsigned int		m_bestEffortCursor;  // where the next tick's turn starts
+	std::vector<RateGroup>	m_rateGroups;  // ProcessRateGroup n is m_rateGroups[n - 1]
+	std::vector<ProcessGroup>	m_processGroups;  // PROCESS_SERIALIZED; a group is dropped once it's empty
+	std::unordered_map<unsigned long, unsigned int>	m_groupIndices;  // data key -> index in m_processGroups
+	ProcessArray		m_endedProcesses;  // ended outside the tick; removed processes are kept here too
+	ProcessArray		m_initBatch;  // reused every update, since onInit() may attach more processes
+	bool				m_isUpdating;
+	bool				m_isRunningWorkers;  // processes are being updated on workers; nothing may attach
+
+	// sleeping
+	unsigned long long	m_timeMs;  // the sum of the deltaMs of every tick so far
+	unsigned long long	m_tickBaseMs;  // m_timeMs before the current tick's deltaMs was added
+	std::vector<ProcessTimer>	m_timers;
+	std::unordered_map<ProcessSignal, std::vector<ProcessWaiter>>	m_signalWaiters;
+	unsigned int		m_numSleeping;  // out of the arrays
+	unsigned int		m_numPaused;  // out of the arrays
+	unsigned int		m_numBlocked;  // waiting for prerequisites, out of the arrays
+
+	// stats
+	ProcessTickStats	m_tickStats;
+	bool				m_isProfilingTypes;
+	std::vector<std::unique_ptr<ProcessTypeCounters>>	m_typeCounters;
+	std::unordered_map<std::type_index, ProcessTypeCounters*>	m_typeCounterMap;
 
 public:
+	enum eConstants { kINFINITE = 0xffffffff };
+
+	ProcessManager();
 	~ProcessManager();
 
-	unsigned int updateProcesses( unsigned long deltaMs );  // updates all attached processes
+	const ProcessTickStats& updateProcesses( unsigned long deltaMs, unsigned long maxMicros = kINFINITE );  // the budget is in microseconds
 	WeakProcessPtr attachProcess( StrongProcessPtr pProcess );  // attaches a process to the process mgr
+
+	// Attaches a process that starts once all of its prerequisites have succeeded.  Prerequisites that aren't attached
+	// yet are attached first; one that has already ended, and isn't attached anymore, counts only if it succeeded.
+	WeakProcessPtr attachAfter( StrongProcessPtr pProcess, const std::vector<StrongProcessPtr>& prerequisites );
+	WeakProcessPtr attachAfter( StrongProcessPtr pProcess, StrongProcessPtr pPrerequisite );
 	void abortAllProcesses( bool immediate );
 
-	unsigned int getProcessCount() const { return m_processList.size(); }
+	ProcessHandle getHandle( const Process& process ) const;  // 0 if the process isn't attached to this manager
+	StrongProcessPtr getProcess( ProcessHandle handle ) const;  // NULL once the process has ended
+
+	// Each of these puts a running process to sleep and returns false if it can't.  A process that puts itself to sleep
+	// from onUpdate() stays asleep from the end of that update.
+	bool sleep( Process& process, unsigned long durationMs );
+	bool sleepUntilWoken( Process& process );
+	bool sleepUntilSignal( Process& process, ProcessSignal signal, unsigned long timeoutMs = 0 );  // 0 waits for the signal only
+	bool sleepUntilDone( Process& process, const Process& target );  // wakes it when target ends, however it ends
+	bool wake( Process& process );  // false if it wasn't asleep
+	unsigned int signal( ProcessSignal signal );  // wakes the processes sleeping until it; returns how many
+	unsigned long long getTimeMs() const { return m_timeMs; }
+
+	// Rate groups.  Each call makes a new group; they live as long as the process mgr.
+	ProcessRateGroup addFixedStepGroup( unsigned long stepMs, unsigned int maxStepsPerTick );  // e.g. 16, 4 for ~60 Hz
+	ProcessRateGroup addEveryNthGroup( unsigned int everyNth );
+	float getInterpolationAlpha( ProcessRateGroup group ) const;  // 1 for the variable rate default
+
+	unsigned int getProcessCount() const { return (unsigned int)m_newProcesses.size() + getRunningCount() + (unsigned int)m_endedProcesses.size() + m_numSleeping + m_numPaused + m_numBlocked; }
+	unsigned int getRunningCount() const;
+	unsigned int getSleepingCount() const { return m_numSleeping; }  // the ones the tick has set aside
+	unsigned int getPausedCount() const { return m_numPaused; }  // likewise
+	unsigned int getBlockedCount() const { return m_numBlocked; }
+
+	const ProcessTickStats& getLastTickStats() const { return m_tickStats; }
+	void setTypeProfiling( bool enable ) { m_isProfilingTypes = enable; }
+	void getTypeStats( std::vector<ProcessTypeStats>& outStats ) const;
+	void resetTypeStats();
 
 private:
+	void runWorkerProcesses( unsigned long deltaMs );
+	void runBestEffortProcesses( unsigned long long deadlineNs );
+	void runRateGroups( unsigned long deltaMs );
+	void runRateGroup( unsigned int index, unsigned long deltaMs );
+	unsigned int allocateSlot( const StrongProcessPtr& pProcess );
+	void releaseDependents( ProcessSlot& processSlot, bool hasSucceeded );
+	void wakeTimers();
+	bool beginSleep( Process& process );
+	bool wake( const ProcessWaiter& waiter );
+	bool isWaiting( const ProcessWaiter& waiter ) const;
+	void appendWaiter( std::vector<ProcessWaiter>& waiters, const ProcessWaiter& waiter );
+	void addTimer( unsigned long long wakeMs, const ProcessWaiter& waiter );
+	void requeue( Process& process, Process::State prevState );
+	void unpark( Process& process, Process::State parkedState );
+	void sweep( ProcessArray& processes );
+	void sweepGroup( unsigned int index );
+	void abort( ProcessArray& processes, bool immediate );
+	void place( Process* pProcess );
+	void remove( ProcessArray& processes, unsigned int index );
+	void finish( Process* pProcess );
+	void updateTypeTickStats();
+	ProcessTypeCounters* getTypeCounters( const Process& process );
+	static void UpdateProcess( Process* pProcess, unsigned long deltaMs, bool isProfiling );
+	void release( Process* pProcess );
 	void clearAllProcesses();  // should only be called by the destructor
 };
 
@@ -0,0 +1,44 @@
+#ifndef PROCESS_POOL_H
+#define PROCESS_POOL_H
+
+#include <memory>
+#include <utility>
+
+#include "process.h"
+#include "utilities/memorypool.h"
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// ProcessPool class
+//
+// One MemoryPool per process class, the same way EventPool works for events.  A process made with MakeProcess() lives
+// in a pool block together with its shared_ptr control block, and the block goes back on the free list when the last
+// reference to the process is dropped, so timers, tweens and other short-lived processes stop churning the heap once
+// the pool has grown to the workload.  A WeakProcessPtr keeps the block from being recycled until it's released too.
+// Like EventPool, the pool is never destroyed.
+//---------------------------------------------------------------------------------------------------------------------
+template <class TProcess>
+class ProcessPool {
+public:
+	// room for the process plus the shared_ptr bookkeeping (vtable, use/weak counts and the allocator)
+	static const size_t kBLOCK_SIZE = sizeof(TProcess) + (4 * sizeof(void*));
+
+	static MemoryPool& get() {
+		static MemoryPool* s_pPool = new MemoryPool(kBLOCK_SIZE);
+		return *s_pPool;
+	}
+
+	static bool reserve( unsigned int numProcesses ) { return get().reserve(numProcesses); }
+};
+
+// Creates a process whose storage comes from the pool for its class.  Use this instead of new/make_shared for
+// processes that are spawned often, children included.
+template <class TProcess, class... Args>
+inline std::shared_ptr<TProcess> MakeProcess( Args&&... args ) {
+	return std::allocate_shared<TProcess>(PoolAllocator<TProcess>(&ProcessPool<TProcess>::get()), std::forward<Args>(args)...);
+}//MakeProcess
+
+}
+
+#endif /* PROCESS_POOL_H */
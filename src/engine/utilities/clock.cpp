@@ -0,0 +1,101 @@
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define CLOCK_HAS_TSC 1
+#endif
+
+#include "clock.h"
+#include "logger.h"
+
+namespace genesis {
+
+// how long to spin while calibrating the TSC; longer is more accurate but delays the first call
+const unsigned long long CLOCK_CALIBRATION_NS = 5000000;
+
+struct ClockCalibration {
+	bool				useTSC;
+	unsigned long long	baseNs;  // CLOCK_MONOTONIC at the end of calibration
+	unsigned long long	baseTicks;  // TSC at the same moment
+	unsigned long long	nsPerTickFixed;  // nanoseconds per tick in 32.32 fixed point
+};
+
+static unsigned long long MonotonicNs() {
+	struct timespec ts;
+	if( clock_gettime(CLOCK_MONOTONIC, &ts) != 0 ) {
+		GEN_ERROR("Unable to read the monotonic clock");
+		return 0;
+	}
+	return ((unsigned long long)ts.tv_sec * 1000000000ULL) + (unsigned long long)ts.tv_nsec;
+}//MonotonicNs
+
+#ifdef CLOCK_HAS_TSC
+// (a * b) >> 32 from 32 bit halves, since 32 bit x86 has no 128 bit type; the bits above 64 are dropped
+static inline unsigned long long MulShift32( unsigned long long a, unsigned long long b ) {
+	unsigned long long aLow = a & 0xffffffffULL, aHigh = a >> 32;
+	unsigned long long bLow = b & 0xffffffffULL, bHigh = b >> 32;
+	return ((aHigh * bHigh) << 32) + (aHigh * bLow) + (aLow * bHigh) + ((aLow * bLow) >> 32);
+}//MulShift32
+
+static bool HasInvariantTSC() {
+	unsigned int eax, ebx, ecx, edx;
+	if( !__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007 )
+		return false;
+	__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+	return (edx & (1 << 8)) != 0;
+}//HasInvariantTSC
+#endif
+
+static ClockCalibration Calibrate() {
+	ClockCalibration calibration;
+	calibration.useTSC = false;
+	calibration.baseNs = 0;
+	calibration.baseTicks = 0;
+	calibration.nsPerTickFixed = 0;
+
+#ifdef CLOCK_HAS_TSC
+	if( HasInvariantTSC() ) {
+		unsigned long long startNs = MonotonicNs();
+		unsigned long long startTicks = __rdtsc();
+		unsigned long long endNs = startNs;
+		while( endNs - startNs < CLOCK_CALIBRATION_NS )
+			endNs = MonotonicNs();
+		unsigned long long endTicks = __rdtsc();
+
+		if( endTicks > startTicks ) {
+			calibration.useTSC = true;
+			calibration.baseNs = endNs;
+			calibration.baseTicks = endTicks;
+			calibration.nsPerTickFixed = ((endNs - startNs) << 32) / (endTicks - startTicks);
+		}
+	}
+#endif
+
+	return calibration;
+}//Calibrate
+
+static const ClockCalibration& GetCalibration() {
+	static const ClockCalibration s_calibration = Calibrate();
+	return s_calibration;
+}//GetCalibration
+
+void Clock::init() {
+	GetCalibration();
+}//Clock::init
+
+unsigned long long Clock::nowNs() {
+	const ClockCalibration& calibration = GetCalibration();
+#ifdef CLOCK_HAS_TSC
+	if( calibration.useTSC ) {
+		unsigned long long ticks = __rdtsc() - calibration.baseTicks;
+		return calibration.baseNs + MulShift32(ticks, calibration.nsPerTickFixed);
+	}
+#endif
+	return MonotonicNs();
+}//Clock::nowNs
+
+bool Clock::isUsingTSC() {
+	return GetCalibration().useTSC;
+}//Clock::isUsingTSC
+
+}
@@ -0,0 +1,27 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// Clock class
+//
+// A monotonic clock with nanosecond resolution for budgets and profiling.  On x86 CPUs with an invariant TSC it reads
+// the time stamp counter directly, which is much cheaper than a system call, after calibrating it against
+// CLOCK_MONOTONIC the first time the clock is used.  Everywhere else it falls back to clock_gettime(CLOCK_MONOTONIC).
+// The values only mean something relative to each other.
+//---------------------------------------------------------------------------------------------------------------------
+class Clock {
+public:
+	static void init();  // calibrates the clock up front; otherwise the first call to now*() pays for it
+
+	static unsigned long long nowNs();
+	static unsigned long long nowUs() { return nowNs() / 1000; }
+	static unsigned long long nowMs() { return nowNs() / 1000000; }
+
+	static bool isUsingTSC();
+};
+
+}
+
+#endif // CLOCK_H
@@ -36,6 +36,20 @@ void ErrorMessenger::show( const std::string& errorMessage, bool isFatal, const
 }//ErrorMessenger::show
 
 
+LogChannel::LogChannel( const char* tag ) : m_tag(tag), m_flags(0), m_isRegistered(false) {
+}//LogChannel::LogChannel
+
+LogChannel::~LogChannel() {
+	if( m_isRegistered.load(std::memory_order_acquire) )
+		Logger::unregisterChannel(this);
+}//LogChannel::~LogChannel
+
+void LogChannel::registerWithLogger() {
+	Logger::init(LOGGINGXML_FILENAME);
+	Logger::registerChannel(this);
+}//LogChannel::registerWithLogger
+
+
 Logger::Logger()
 {
 	// set up the default log tags
@@ -46,6 +60,15 @@ Logger::Logger()
 }//Logger::Logger
 
 Logger::~Logger() {
+	// the channels outlive us, so leave them disabled and ready to register with the next logger
+	m_tagsMutex.lock();
+	for( auto it = m_channels.begin(); it != m_channels.end(); ++it ) {
+		(*it)->setFlags(0);
+		(*it)->m_isRegistered.store(false, std::memory_order_release);
+	}
+	m_channels.clear();
+	m_tagsMutex.unlock();
+
 	m_errorMessengersMutex.lock();
 	for( auto it = m_errorMessengers.begin(); it != m_errorMessengers.end(); ++it ) {
 		ErrorMessenger* pMessenger = (*it);
@@ -73,6 +96,17 @@ void Logger::setDisplayFlags( const std::string& tag, unsigned char flags ) {
 	s_pLogger->setDisplayFlagsInternal(tag, flags);
 }//Logger::setDisplayFlags
 
+void Logger::registerChannel( LogChannel* pChannel ) {
+	GEN_ASSERT(s_pLogger);
+	s_pLogger->registerChannelInternal(pChannel);
+}//Logger::registerChannel
+
+void Logger::unregisterChannel( LogChannel* pChannel ) {
+	// channels are often statics, so they may outlive the logger
+	if( s_pLogger )
+		s_pLogger->unregisterChannelInternal(pChannel);
+}//Logger::unregisterChannel
+
 void Logger::destroy() {
 	delete s_pLogger;
 	s_pLogger = 0;
@@ -140,9 +174,33 @@ void Logger::setDisplayFlagsInternal( const std::string& tag, unsigned char flag
 	else {
 		m_tags.erase(tag);
 	}
+
+	// refresh the cached flags of any channels for this tag
+	for( auto it = m_channels.begin(); it != m_channels.end(); ++it ) {
+		if( tag == (*it)->getTag() )
+			(*it)->setFlags(flags);
+	}
 	m_tagsMutex.unlock();
 }//Logger::setDisplayFlagsInternal
 
+void Logger::registerChannelInternal( LogChannel* pChannel ) {
+	m_tagsMutex.lock();
+	if( !pChannel->m_isRegistered.load(std::memory_order_relaxed) ) {  // another thread may have beaten us to it
+		m_channels.push_back(pChannel);
+		Tags::iterator findIt = m_tags.find(pChannel->getTag());
+		pChannel->setFlags((findIt != m_tags.end()) ? findIt->second : 0);
+		pChannel->m_isRegistered.store(true, std::memory_order_release);
+	}
+	m_tagsMutex.unlock();
+}//Logger::registerChannelInternal
+
+void Logger::unregisterChannelInternal( LogChannel* pChannel ) {
+	m_tagsMutex.lock();
+	m_channels.remove(pChannel);
+	pChannel->m_isRegistered.store(false, std::memory_order_release);
+	m_tagsMutex.unlock();
+}//Logger::unregisterChannelInternal
+
 void Logger::addErrorMessenger( ErrorMessenger* pMessenger ) {
 	m_errorMessengersMutex.lock();
 	m_errorMessengers.push_back(pMessenger);
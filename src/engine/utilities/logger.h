@@ -4,6 +4,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <atomic>
 #include <tbb/mutex.h>
 #include <Xm/Xm.h>
 #include <Xm/MessageB.h>
@@ -41,6 +42,41 @@ public:
 	void show( const std::string& errorMessage, bool isFatal, const char* funcName, const char* sourceFile, unsigned int lineNum );
 };
 
+//---------------------------------------------------------------------------------------------------------------------
+// LogChannel class
+//
+// Caches the display flags of a single tag so that hot code can check whether the tag is enabled with one relaxed
+// load instead of locking the logger and searching the tag map.  A channel doesn't touch the logger when it's
+// constructed, so it's safe as a static; it registers itself the first time it's checked (initializing the logger if
+// need be) and is refreshed whenever the flags for its tag change.  Destroying the logger drops it back to
+// unregistered, so it picks up the flags of the next one.  Use it with GEN_LOG_CHANNEL().
+//---------------------------------------------------------------------------------------------------------------------
+class LogChannel {
+	friend class Logger;
+
+	const char*						m_tag;
+	std::atomic<unsigned char>		m_flags;
+	std::atomic<bool>				m_isRegistered;  // written by the logger under its tags mutex
+
+public:
+	explicit LogChannel( const char* tag );
+	~LogChannel();
+
+	const char* getTag() const { return m_tag; }
+	bool isEnabled() {
+		if( !m_isRegistered.load(std::memory_order_acquire) )
+			registerWithLogger();
+		return m_flags.load(std::memory_order_relaxed) != 0;
+	}
+
+private:
+	void registerWithLogger();
+	void setFlags( unsigned char flags ) { m_flags.store(flags, std::memory_order_relaxed); }
+
+	LogChannel( const LogChannel& );
+	LogChannel& operator=( const LogChannel& );
+};
+
 class Logger
 {
 public:
@@ -53,8 +89,10 @@ public:
 protected:
 	typedef std::map<std::string, unsigned char> Tags;
 	typedef std::list<ErrorMessenger*> ErrorMessengerList;
+	typedef std::list<LogChannel*> LogChannelList;
 
 	Tags				m_tags;
+	LogChannelList		m_channels;  // protected by m_tagsMutex, since channels mirror m_tags
 	tbb::mutex			m_tagsMutex;
 
 	ErrorMessengerList	m_errorMessengers;
@@ -68,11 +106,15 @@ public:
 	static void init( const char* loggingConfigFilename );
 	static void log(const std::string& tag, const std::string& message, const char* funcName, const char* sourceFile, unsigned int lineNum );
 	static void setDisplayFlags( const std::string& tag, unsigned char flags );
+	static void registerChannel( LogChannel* pChannel );
+	static void unregisterChannel( LogChannel* pChannel );
 	static void destroy();
 
 	void initInternal( const char* loggingConfigFilename );
 	void logInternal(const std::string& tag, const std::string& message, const char* funcName, const char* sourceFile, unsigned int lineNum );
 	void setDisplayFlagsInternal( const std::string& tag, unsigned char flags );
+	void registerChannelInternal( LogChannel* pChannel );
+	void unregisterChannelInternal( LogChannel* pChannel );
 
 	// error messengers
 	void addErrorMessenger( ErrorMessenger* pMessenger );
@@ -150,6 +192,19 @@ private:
 		} \
 		while (0) \
 
+// Same as GEN_LOG(), but for a LogChannel.  When the channel's tag is disabled this is a single branch on a cached flag;
+// the message expression isn't even evaluated, so it's safe to build strings in it on hot paths.
+#define GEN_LOG_CHANNEL(channel, str) \
+		do \
+		{ \
+				if ((channel).isEnabled()) \
+				{ \
+						std::string s((str)); \
+						Logger::log((channel).getTag(), s, NULL, NULL, 0); \
+				} \
+		} \
+		while (0) \
+
 // This macro replaces GCC_ASSERT().
 #define GEN_ASSERT(expr) \
 		do \
@@ -170,6 +225,7 @@ private:
 #define GEN_WARNING(str) do { (void)sizeof(str); } while(0)
 #define GEN_INFO(str) do { (void)sizeof(str); } while(0)
 #define GEN_LOG(tag, str) do { (void)sizeof(tag); (void)sizeof(str); } while(0)
+#define GEN_LOG_CHANNEL(channel, str) do { (void)sizeof(str); } while(0)  // channels don't exist in release builds
 #define GEN_ASSERT(expr) do { (void)sizeof(expr); } while(0)
 
 #endif  // !defined NDEBUG
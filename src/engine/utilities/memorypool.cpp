@@ -0,0 +1,105 @@
+#include <atomic>
+#include <cstdlib>
+
+#include "memorypool.h"
+#include "logger.h"
+
+namespace genesis {
+
+static std::atomic<unsigned long> s_heapAllocationCount(0);
+
+static size_t RoundUpToAlignment( size_t size ) {
+	return (size + MemoryPool::kALIGNMENT - 1) & ~(MemoryPool::kALIGNMENT - 1);
+}//RoundUpToAlignment
+
+MemoryPool::MemoryPool( size_t blockSize, unsigned int blocksPerArena ) {
+	m_blockSize = RoundUpToAlignment(blockSize < sizeof(Block) ? sizeof(Block) : blockSize);
+	m_blocksPerArena = (blocksPerArena > 0) ? blocksPerArena : 1;
+	m_pFreeList = NULL;
+	m_pArenas = NULL;
+	m_arenaCount = 0;
+	m_blocksInUse = 0;
+}//MemoryPool::MemoryPool
+
+MemoryPool::~MemoryPool() {
+	if( m_blocksInUse > 0 )
+		GEN_WARNING("Destroying a memory pool that still has blocks in use");
+
+	while( m_pArenas ) {
+		Arena* pNext = m_pArenas->pNext;
+		std::free(m_pArenas);
+		m_pArenas = pNext;
+	}
+}//MemoryPool::~MemoryPool
+
+void* MemoryPool::allocate() {
+	tbb::spin_mutex::scoped_lock lock(m_mutex);
+	if( !m_pFreeList && !grow(m_blocksPerArena) )
+		return NULL;
+
+	Block* pBlock = m_pFreeList;
+	m_pFreeList = pBlock->pNext;
+	++m_blocksInUse;
+	return pBlock;
+}//MemoryPool::allocate
+
+void MemoryPool::free( void* pBlock ) {
+	if( !pBlock )
+		return;
+
+	tbb::spin_mutex::scoped_lock lock(m_mutex);
+	Block* pFreed = static_cast<Block*>(pBlock);
+	pFreed->pNext = m_pFreeList;
+	m_pFreeList = pFreed;
+	--m_blocksInUse;
+}//MemoryPool::free
+
+bool MemoryPool::reserve( unsigned int numBlocks ) {
+	tbb::spin_mutex::scoped_lock lock(m_mutex);
+	unsigned int available = 0;
+	for( Block* pBlock = m_pFreeList; pBlock && available < numBlocks; pBlock = pBlock->pNext )
+		++available;
+
+	if( available >= numBlocks )
+		return true;
+
+	return grow(numBlocks - available);
+}//MemoryPool::reserve
+
+unsigned long MemoryPool::getHeapAllocationCount() {
+	return s_heapAllocationCount.load(std::memory_order_relaxed);
+}//MemoryPool::getHeapAllocationCount
+
+void MemoryPool::countHeapAllocation() {
+	s_heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+}//MemoryPool::countHeapAllocation
+
+//---------------------------------------------------------------------------------------------------------------------
+// Adds a new arena of numBlocks blocks to the free list.  The caller must hold the lock.
+//---------------------------------------------------------------------------------------------------------------------
+bool MemoryPool::grow( unsigned int numBlocks ) {
+	size_t headerSize = RoundUpToAlignment(sizeof(Arena));
+	char* pMemory = static_cast<char*>(std::malloc(headerSize + (m_blockSize * numBlocks)));
+	if( !pMemory ) {
+		GEN_ERROR("Out of memory growing a memory pool");
+		return false;
+	}
+	countHeapAllocation();
+
+	Arena* pArena = reinterpret_cast<Arena*>(pMemory);
+	pArena->pNext = m_pArenas;
+	m_pArenas = pArena;
+	++m_arenaCount;
+
+	// thread the new blocks onto the front of the free list
+	char* pFirstBlock = pMemory + headerSize;
+	for( unsigned int i = numBlocks; i > 0; --i ) {
+		Block* pBlock = reinterpret_cast<Block*>(pFirstBlock + (m_blockSize * (i - 1)));
+		pBlock->pNext = m_pFreeList;
+		m_pFreeList = pBlock;
+	}
+
+	return true;
+}//MemoryPool::grow
+
+}
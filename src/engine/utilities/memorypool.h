@@ -0,0 +1,114 @@
+#ifndef MEMORYPOOL_H
+#define MEMORYPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <tbb/spin_mutex.h>
+
+namespace genesis {
+
+//---------------------------------------------------------------------------------------------------------------------
+// MemoryPool class
+//
+// A fixed-size block allocator.  Blocks are carved out of large arenas and recycled through an intrusive free list, so
+// once a pool has grown to the high-water mark of a workload, allocate() and free() never touch the heap.  The free
+// list is guarded by a spin lock so a block may be released on a different thread than the one that allocated it
+// (e.g. an event created on a worker thread and released by the main loop).
+//---------------------------------------------------------------------------------------------------------------------
+class MemoryPool {
+	struct Block {
+		Block*			pNext;
+	};
+
+	struct Arena {
+		Arena*			pNext;
+	};
+
+	size_t				m_blockSize;  // size of each block, rounded up to the pool alignment
+	unsigned int		m_blocksPerArena;  // number of blocks added each time the pool grows
+	Block*				m_pFreeList;
+	Arena*				m_pArenas;
+	unsigned long		m_arenaCount;
+	unsigned long		m_blocksInUse;
+	tbb::spin_mutex		m_mutex;
+
+public:
+	static const size_t kALIGNMENT = 16;
+
+	explicit MemoryPool( size_t blockSize, unsigned int blocksPerArena = 256 );
+	~MemoryPool();
+
+	void* allocate();
+	void free( void* pBlock );
+	bool reserve( unsigned int numBlocks );  // makes sure at least numBlocks are available without growing
+
+	size_t getBlockSize() const { return m_blockSize; }
+	unsigned long getArenaCount() const { return m_arenaCount; }
+	unsigned long getBlocksInUse() const { return m_blocksInUse; }
+
+	// The number of times any pool had to go to the heap, either to grow or because a request didn't fit in a block.
+	// A steady-state workload should see this stay flat from frame to frame.
+	static unsigned long getHeapAllocationCount();
+	static void countHeapAllocation();
+
+private:
+	bool grow( unsigned int numBlocks );
+
+	MemoryPool( const MemoryPool& );
+	MemoryPool& operator=( const MemoryPool& );
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// PoolAllocator class
+//
+// A standard allocator that hands out single objects from a MemoryPool.  This is meant to be used with
+// std::allocate_shared(), which rebinds the allocator to its combined control block and object; anything that doesn't
+// fit in a pool block (or array allocations) falls back to the heap.
+//---------------------------------------------------------------------------------------------------------------------
+template <class T>
+class PoolAllocator {
+	template <class U> friend class PoolAllocator;
+
+	MemoryPool*			m_pPool;
+
+public:
+	typedef T value_type;
+
+	explicit PoolAllocator( MemoryPool* pPool ) : m_pPool(pPool) {}
+	template <class U> PoolAllocator( const PoolAllocator<U>& other ) : m_pPool(other.m_pPool) {}
+
+	T* allocate( size_t n ) {
+		if( fitsInBlock(n) ) {
+			void* pBlock = m_pPool->allocate();
+			if( !pBlock )
+				throw std::bad_alloc();  // like any standard allocator, so allocate_shared() never constructs into NULL
+			return static_cast<T*>(pBlock);
+		}
+		MemoryPool::countHeapAllocation();
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate( T* p, size_t n ) {
+		if( fitsInBlock(n) )
+			m_pPool->free(p);
+		else
+			::operator delete(p);
+	}
+
+	MemoryPool* getPool() const { return m_pPool; }
+
+private:
+	bool fitsInBlock( size_t n ) const {
+		return (n == 1 && sizeof(T) <= m_pPool->getBlockSize() && alignof(T) <= MemoryPool::kALIGNMENT);
+	}
+};
+
+template <class T, class U>
+inline bool operator==( const PoolAllocator<T>& a, const PoolAllocator<U>& b ) { return a.getPool() == b.getPool(); }
+
+template <class T, class U>
+inline bool operator!=( const PoolAllocator<T>& a, const PoolAllocator<U>& b ) { return a.getPool() != b.getPool(); }
+
+}
+
+#endif // MEMORYPOOL_H
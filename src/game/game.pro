@@ -29,7 +29,7 @@ unix:!macx: PRE_TARGETDEPS += $$PWD/../../lib/libengine.a
 DESTDIR = ../../../game
 }
 
-LIBS += -lz -ltbb -lXm -lXt
+LIBS += -lz -ltbb -lXm -lXt -lrt
 
 DISTFILES += \
 	../../game/logging.xml
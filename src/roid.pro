@@ -2,4 +2,7 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     engine \
-    game
+    game \
+    tools
+
+tools.depends = engine
@@ -0,0 +1,23 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocationcounter.h"
+
+static std::atomic<unsigned long> s_numAllocations(0);
+
+unsigned long GetNumAllocations() {
+	return s_numAllocations.load(std::memory_order_relaxed);
+}//GetNumAllocations
+
+void* operator new( size_t size ) {
+	s_numAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if( !p )
+		throw std::bad_alloc();
+	return p;
+}//operator new
+
+void operator delete( void* p ) noexcept {
+	free(p);
+}//operator delete
@@ -0,0 +1,8 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+// Heap allocations made through operator new since the program started.  allocationcounter.cpp replaces the global
+// operator new and delete to count them; it's a file of its own so the compiler never sees the pair inlined together.
+unsigned long GetNumAllocations();
+
+#endif /* ALLOCATION_COUNTER_H */
@@ -0,0 +1,34 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+QMAKE_CXXFLAGS += -std=c++11
+
+SOURCES += main.cpp \
+    allocationcounter.cpp
+
+HEADERS += allocationcounter.h
+
+
+CONFIG(debug, debug|release) {
+unix:!macx: LIBS += -L$$PWD/../../../lib/ -lengined
+
+INCLUDEPATH += $$PWD/../../engine
+DEPENDPATH += $$PWD/../../../
+
+unix:!macx: PRE_TARGETDEPS += $$PWD/../../../lib/libengined.a
+}
+
+CONFIG(release, debug|release) {
+DEFINES += NDEBUG
+
+unix:!macx: LIBS += -L$$PWD/../../../lib/ -lengine
+
+INCLUDEPATH += $$PWD/../../engine
+DEPENDPATH += $$PWD/../../../
+
+unix:!macx: PRE_TARGETDEPS += $$PWD/../../../lib/libengine.a
+}
+
+LIBS += -lz -ltbb -lXm -lXt -lrt
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "events/EventManagerImp.h"
+#include "events/EventPool.h"
+#include "utilities/clock.h"
+
+#include "allocationcounter.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Benchmark of a frame of queued events: every frame queues a batch of events spread over a few types, then update()
+// dispatches them to two listeners per type.  Three setups are measured:
+//
+//		list, new	the queue EventManager used to have, kept here as a reference: two std::lists of shared_ptrs
+//					swapped every update, a std::map of std::list listeners, delegates that take the event by value
+//		ring, new	EventManager with events created by plain new
+//		ring, pool	EventManager with events created by MakeEvent(), out of the event class's pool
+//
+// Heap allocations are counted with a replaced global operator new, and reported per frame once the queues and pools
+// have warmed up.
+//
+// Then abortEvent() is timed on a queue of 100k events spread evenly over 1000 types, for the old list queue and for
+// EventManager: aborting all 100 events of a type, which the list has to scan the whole queue for, and aborting the
+// oldest event of a type, which is near the front and so the list's best case.  The queue is dispatched afterwards to
+// check that exactly the aborted events went missing.
+//
+// Exits with 1 if a setup loses or duplicates an event, so it doubles as a test.
+//
+// Usage: eventbench [numFrames]
+//---------------------------------------------------------------------------------------------------------------------
+
+using namespace genesis;
+
+static const unsigned int kEVENTS_PER_FRAME[] = { 1000, 10000, 50000 };
+static const unsigned int kDEFAULT_NUM_FRAMES = 50;
+static const unsigned int kNUM_WARMUP_FRAMES = 3;
+static const unsigned int kNUM_TYPES = 4;
+static const unsigned int kLISTENERS_PER_TYPE = 2;
+static const unsigned int kABORT_QUEUE_SIZE = 100000;
+static const unsigned int kNUM_ABORT_TYPES = 1000;
+static const unsigned int kNUM_ABORTS = 100;  // of each kind, each from a type of its own
+static const EventType kFIRST_ABORT_TYPE = 1000000;
+
+static const EventType kBENCH_TYPES[kNUM_TYPES] = {
+	EventTypeHash("BenchEvent0"), EventTypeHash("BenchEvent1"), EventTypeHash("BenchEvent2"), EventTypeHash("BenchEvent3"),
+};
+
+// one class for all the bench types, so the pool is shared by them like it would be by the events of one class
+class BenchEvent : public BaseEventData {
+	EventType		m_type;
+	unsigned int	m_seq;
+	float			m_x;
+	float			m_y;
+
+public:
+	BenchEvent( const EventType& type, unsigned int seq ) : m_type(type), m_seq(seq), m_x((float)seq), m_y(0.0f) {}
+
+	virtual const EventType& getEventType() const { return m_type; }
+	virtual IEventDataPtr copy() const { return IEventDataPtr(new BenchEvent(m_type, m_seq)); }
+	virtual const std::string getName() const { return "BenchEvent"; }
+
+	unsigned int getSeq() const { return m_seq; }
+};
+
+class BenchListener {
+	unsigned long long	m_numCalls;
+	unsigned long long	m_seqSum;
+
+public:
+	BenchListener() : m_numCalls(0), m_seqSum(0) {}
+
+	void onEvent( const IEventDataPtr& pEvent ) {
+		++m_numCalls;
+		m_seqSum += static_cast<const BenchEvent*>(pEvent.get())->getSeq();
+	}
+
+	unsigned long long getNumCalls() const { return m_numCalls; }
+	unsigned long long getSeqSum() const { return m_seqSum; }
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// The list based queue and update() of EventManager before events were pooled and queued in a ring, minus logging
+// and the realtime queue.
+//---------------------------------------------------------------------------------------------------------------------
+class ListEventManager {
+	typedef fastdelegate::FastDelegate1<IEventDataPtr> ListenerDelegate;  // the old delegates took the event by value
+	typedef std::list<ListenerDelegate> ListenerList;
+	typedef std::map<EventType, ListenerList> ListenerMap;
+	typedef std::list<IEventDataPtr> Queue;
+
+	ListenerMap		m_listeners;
+	Queue			m_queues[2];
+	int				m_activeQueue;
+
+public:
+	ListEventManager() : m_activeQueue(0) {}
+
+	void addListener( const ListenerDelegate& listener, const EventType& type ) { m_listeners[type].push_back(listener); }
+
+	bool queueEvent( const IEventDataPtr& pEvent ) {
+		if( m_listeners.find(pEvent->getEventType()) == m_listeners.end() )
+			return false;
+		m_queues[m_activeQueue].push_back(pEvent);
+		return true;
+	}
+
+	bool abortEvent( const EventType& type, bool allOfType ) {
+		if( m_listeners.find(type) == m_listeners.end() )
+			return false;
+
+		bool success = false;
+		Queue& queue = m_queues[m_activeQueue];
+		auto it = queue.begin();
+		while( it != queue.end() ) {
+			auto thisIt = it;
+			++it;
+			if( (*thisIt)->getEventType() == type ) {
+				queue.erase(thisIt);
+				success = true;
+				if( !allOfType )
+					break;
+			}
+		}
+		return success;
+	}
+
+	void update() {
+		int queueToProcess = m_activeQueue;
+		m_activeQueue = (m_activeQueue + 1) % 2;
+		m_queues[m_activeQueue].clear();
+
+		while( !m_queues[queueToProcess].empty() ) {
+			IEventDataPtr pEvent = m_queues[queueToProcess].front();
+			m_queues[queueToProcess].pop_front();
+
+			auto findIt = m_listeners.find(pEvent->getEventType());
+			if( findIt != m_listeners.end() ) {
+				for( auto it = findIt->second.begin(); it != findIt->second.end(); ++it ) {
+					ListenerDelegate listener = (*it);
+					listener(pEvent);
+				}
+			}
+		}
+	}
+};
+
+// adapts a BenchListener to the old by-value delegate
+class ListBenchListener {
+	BenchListener&	m_listener;
+
+public:
+	explicit ListBenchListener( BenchListener& listener ) : m_listener(listener) {}
+
+	void onEvent( IEventDataPtr pEvent ) { m_listener.onEvent(pEvent); }
+};
+
+enum BenchSetup {
+	SETUP_LIST_NEW,
+	SETUP_RING_NEW,
+	SETUP_RING_POOL,
+	NUM_SETUPS,
+};
+
+static const char* kSETUP_NAMES[NUM_SETUPS] = { "list, new", "ring, new", "ring, pool" };
+
+struct BenchResult {
+	unsigned long long	medianNs;  // per frame
+	unsigned long long	bestNs;
+	double				allocationsPerFrame;
+	bool				isIntact;
+};
+
+static IEventDataPtr CreateEvent( BenchSetup setup, unsigned int seq ) {
+	const EventType& type = kBENCH_TYPES[seq % kNUM_TYPES];
+	if( setup == SETUP_RING_POOL )
+		return MakeEvent<BenchEvent>(type, seq);
+	return IEventDataPtr(new BenchEvent(type, seq));
+}//CreateEvent
+
+static BenchResult RunBench( BenchSetup setup, unsigned int eventsPerFrame, unsigned int numFrames ) {
+	EventManager manager("eventbench", false);
+	ListEventManager listManager;
+	std::vector<BenchListener> listeners(kNUM_TYPES * kLISTENERS_PER_TYPE);
+	std::vector<ListBenchListener> listListeners;
+	listListeners.reserve(listeners.size());
+	for( unsigned int i = 0; i < listeners.size(); ++i ) {
+		const EventType& type = kBENCH_TYPES[i / kLISTENERS_PER_TYPE];
+		listListeners.push_back(ListBenchListener(listeners[i]));
+		if( setup == SETUP_LIST_NEW )
+			listManager.addListener(fastdelegate::MakeDelegate(&listListeners[i], &ListBenchListener::onEvent), type);
+		else
+			manager.addListener(fastdelegate::MakeDelegate(&listeners[i], &BenchListener::onEvent), type);
+	}
+
+	BenchResult result = BenchResult();
+	std::vector<unsigned long long> frameNs;
+	frameNs.reserve(numFrames);
+	unsigned long numAllocations = 0;
+	for( unsigned int frame = 0; frame < kNUM_WARMUP_FRAMES + numFrames; ++frame ) {
+		unsigned long startAllocations = GetNumAllocations();
+		unsigned long long startNs = Clock::nowNs();
+		for( unsigned int seq = 0; seq < eventsPerFrame; ++seq ) {
+			if( setup == SETUP_LIST_NEW )
+				listManager.queueEvent(CreateEvent(setup, seq));
+			else
+				manager.queueEvent(CreateEvent(setup, seq));
+		}
+		if( setup == SETUP_LIST_NEW )
+			listManager.update();
+		else
+			manager.update();
+		unsigned long long elapsedNs = Clock::nowNs() - startNs;
+
+		if( frame >= kNUM_WARMUP_FRAMES ) {
+			frameNs.push_back(elapsedNs);
+			numAllocations += GetNumAllocations() - startAllocations;
+		}
+	}
+
+	std::sort(frameNs.begin(), frameNs.end());
+	result.medianNs = frameNs[frameNs.size() / 2];
+	result.bestNs = frameNs.front();
+	result.allocationsPerFrame = (double)numAllocations / numFrames;
+
+	// every listener sees every event of its type once a frame
+	unsigned long long numFramesRun = kNUM_WARMUP_FRAMES + numFrames;
+	result.isIntact = true;
+	for( unsigned int i = 0; i < listeners.size(); ++i ) {
+		unsigned int typeIndex = i / kLISTENERS_PER_TYPE;
+		unsigned long long numOfType = 0;
+		unsigned long long seqSum = 0;
+		for( unsigned int seq = typeIndex; seq < eventsPerFrame; seq += kNUM_TYPES ) {
+			++numOfType;
+			seqSum += seq;
+		}
+		if( listeners[i].getNumCalls() != numOfType * numFramesRun || listeners[i].getSeqSum() != seqSum * numFramesRun )
+			result.isIntact = false;
+	}
+	return result;
+}//RunBench
+
+struct AbortResult {
+	unsigned long long	allOfTypeNs;  // median of the aborts
+	unsigned long long	oldestNs;
+	bool				isIntact;
+};
+
+// the first kNUM_ABORTS types lose all their events, the next kNUM_ABORTS their oldest one
+template <class TManager>
+static AbortResult RunAbortBench( TManager& manager, BenchListener& listener ) {
+	for( unsigned int seq = 0; seq < kABORT_QUEUE_SIZE; ++seq )
+		manager.queueEvent(IEventDataPtr(new BenchEvent(kFIRST_ABORT_TYPE + (seq % kNUM_ABORT_TYPES), seq)));
+
+	AbortResult result = AbortResult();
+	result.isIntact = true;
+	std::vector<unsigned long long> allOfTypeNs;
+	std::vector<unsigned long long> oldestNs;
+	for( unsigned int i = 0; i < kNUM_ABORTS; ++i ) {
+		unsigned long long startNs = Clock::nowNs();
+		result.isIntact = manager.abortEvent(kFIRST_ABORT_TYPE + i, true) && result.isIntact;
+		allOfTypeNs.push_back(Clock::nowNs() - startNs);
+
+		startNs = Clock::nowNs();
+		result.isIntact = manager.abortEvent(kFIRST_ABORT_TYPE + kNUM_ABORTS + i, false) && result.isIntact;
+		oldestNs.push_back(Clock::nowNs() - startNs);
+	}
+	std::sort(allOfTypeNs.begin(), allOfTypeNs.end());
+	std::sort(oldestNs.begin(), oldestNs.end());
+	result.allOfTypeNs = allOfTypeNs[allOfTypeNs.size() / 2];
+	result.oldestNs = oldestNs[oldestNs.size() / 2];
+
+	manager.update();
+	unsigned long long numLeft = kABORT_QUEUE_SIZE - (kNUM_ABORTS * (kABORT_QUEUE_SIZE / kNUM_ABORT_TYPES)) - kNUM_ABORTS;
+	unsigned long long seqSum = 0;
+	for( unsigned int seq = 0; seq < kABORT_QUEUE_SIZE; ++seq ) {
+		unsigned int typeIndex = seq % kNUM_ABORT_TYPES;
+		if( typeIndex >= kNUM_ABORTS && !(typeIndex < 2 * kNUM_ABORTS && seq < kNUM_ABORT_TYPES) )
+			seqSum += seq;
+	}
+	if( listener.getNumCalls() != numLeft || listener.getSeqSum() != seqSum )
+		result.isIntact = false;
+	return result;
+}//RunAbortBench
+
+static bool PrintAbortResult( const char* setupName, const AbortResult& result ) {
+	printf("%10u %12s %14.2f %14.2f%s\n", kABORT_QUEUE_SIZE, setupName, result.allOfTypeNs / 1000.0, result.oldestNs / 1000.0,
+		result.isIntact ? "" : "  WRONG EVENTS ABORTED");
+	return result.isIntact;
+}//PrintAbortResult
+
+int main( int argc, char** argv ) {
+	unsigned int numFrames = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 10) : kDEFAULT_NUM_FRAMES;
+	if( numFrames == 0 )
+		numFrames = 1;
+
+	Clock::init();
+	EventPool<BenchEvent>::reserve(kEVENTS_PER_FRAME[sizeof(kEVENTS_PER_FRAME) / sizeof(kEVENTS_PER_FRAME[0]) - 1]);
+
+	bool isIntact = true;
+	printf("%10s %12s %12s %12s %12s %12s\n", "events", "setup", "best us", "median us", "ns/event", "allocs/frame");
+	for( unsigned int i = 0; i < sizeof(kEVENTS_PER_FRAME) / sizeof(kEVENTS_PER_FRAME[0]); ++i ) {
+		for( unsigned int setup = 0; setup < NUM_SETUPS; ++setup ) {
+			BenchResult result = RunBench((BenchSetup)setup, kEVENTS_PER_FRAME[i], numFrames);
+			printf("%10u %12s %12.1f %12.1f %12.1f %12.1f%s\n", kEVENTS_PER_FRAME[i], kSETUP_NAMES[setup], result.bestNs / 1000.0,
+				result.medianNs / 1000.0, (double)result.medianNs / kEVENTS_PER_FRAME[i], result.allocationsPerFrame,
+				result.isIntact ? "" : "  LOST OR DUPLICATED EVENTS");
+			isIntact = isIntact && result.isIntact;
+		}
+	}
+
+	printf("\n%10s %12s %14s %14s\n", "queued", "setup", "all of type us", "oldest us");
+	{
+		ListEventManager listManager;
+		BenchListener listener;
+		ListBenchListener listListener(listener);
+		for( unsigned int i = 0; i < kNUM_ABORT_TYPES; ++i )
+			listManager.addListener(fastdelegate::MakeDelegate(&listListener, &ListBenchListener::onEvent), kFIRST_ABORT_TYPE + i);
+		isIntact = PrintAbortResult(kSETUP_NAMES[SETUP_LIST_NEW], RunAbortBench(listManager, listener)) && isIntact;
+	}
+	{
+		EventManager manager("eventbench", false);
+		BenchListener listener;
+		for( unsigned int i = 0; i < kNUM_ABORT_TYPES; ++i )
+			manager.addListener(fastdelegate::MakeDelegate(&listener, &BenchListener::onEvent), kFIRST_ABORT_TYPE + i);
+		isIntact = PrintAbortResult("ring", RunAbortBench(manager, listener)) && isIntact;
+	}
+
+	return isIntact ? 0 : 1;
+}//main
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "events/EventManagerImp.h"
+#include "events/SharedEventBus.h"
+#include "utilities/clock.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Loopback test and benchmark for SharedEventBus.  The bench creates a segment and forks a peer process that opens
+// it, then measures
+//
+//		latency		POD pings sent one at a time and echoed back by the peer; reports round trip times
+//		throughput	serialized events of varying sizes streamed through a small ring, so it keeps wrapping around
+//					and padding its end; the peer checks every event arrives in order and intact
+//
+// Usage: eventbusbench [numEvents] [ringBytes]
+// Exits with 1 if anything was lost or corrupted, so it doubles as a test.
+//---------------------------------------------------------------------------------------------------------------------
+
+using namespace genesis;
+
+static const char* kSEGMENT_NAME = "/roid_eventbusbench";
+static const unsigned int kNUM_PINGS = 100000;
+static const unsigned int kDEFAULT_NUM_EVENTS = 1000000;
+static const unsigned int kDEFAULT_RING_BYTES = 16 * 1024;
+static const unsigned int kMAX_PAYLOAD = 600;  // odd sizes up to this keep the messages from lining up with the ring
+static const unsigned long long kTIMEOUT_NS = 5000000000ULL;  // with no progress, the other side has died
+
+struct BenchPing {
+	unsigned long long	seq;
+	unsigned long long	sentNs;  // on the sender's clock; the peer only echoes it
+};
+
+struct BenchResult {
+	unsigned long long	received;
+	unsigned long long	outOfOrder;
+	unsigned long long	corrupt;
+};
+
+static const EventType kPING_TYPE = EventTypeHash("BenchPing");
+static const EventType kPONG_TYPE = EventTypeHash("BenchPong");
+static const EventType kRESULT_TYPE = EventTypeHash("BenchResult");
+
+static unsigned int PayloadLength( unsigned int seq ) { return (seq * 7919) % kMAX_PAYLOAD; }
+static char PayloadChar( unsigned int seq ) { return (char)('a' + (seq % 26)); }
+
+class BenchEvent : public BaseEventData {
+	unsigned int	m_seq;
+	std::string		m_payload;
+
+public:
+	GEN_EVENT_TYPE(BenchEvent);
+
+	BenchEvent() : m_seq(0) {}
+	explicit BenchEvent( unsigned int seq ) : m_seq(seq), m_payload(PayloadLength(seq), PayloadChar(seq)) {}
+
+	virtual const EventType& getEventType() const { return sk_EventType; }
+	virtual IEventDataPtr copy() const { return IEventDataPtr(new BenchEvent(m_seq)); }
+	virtual const std::string getName() const { return "BenchEvent"; }
+
+	virtual unsigned short getSchemaVersion() const { return BASEEVENTDATA_SCHEMA_VERSION; }
+	virtual bool serialize( EventWriter& out ) const { return BaseEventData::serialize(out) && out.write(m_seq) && out.writeString(m_payload); }
+	virtual bool deserialize( EventReader& in ) { return BaseEventData::deserialize(in) && in.read(m_seq) && in.readString(m_payload); }
+
+	unsigned int getSeq() const { return m_seq; }
+	bool isIntact() const {
+		return m_payload.size() == PayloadLength(m_seq) && m_payload.find_first_not_of(PayloadChar(m_seq)) == std::string::npos;
+	}
+};
+GEN_DEFINE_EVENT_TYPE(BenchEvent);
+
+//---------------------------------------------------------------------------------------------------------------------
+// The forked side: echoes pings and checks the stream of bench events.
+//---------------------------------------------------------------------------------------------------------------------
+class BenchPeer {
+	SharedEventBus&		m_bus;
+	unsigned int		m_numPings;
+	BenchResult			m_result;
+
+public:
+	explicit BenchPeer( SharedEventBus& bus ) : m_bus(bus), m_numPings(0) { m_result = BenchResult(); }
+
+	void onPing( const EventType& type, const void* pPayload, size_t size ) {
+		(void)type;
+		(void)size;
+		++m_numPings;
+		while( !m_bus.sendPod(kPONG_TYPE, *(const BenchPing*)pPayload) )
+			std::this_thread::yield();  // our outgoing ring is full until the bench polls
+	}
+
+	void onBenchEvent( const IEventDataPtr& pEvent ) {
+		const BenchEvent& event = *static_cast<const BenchEvent*>(pEvent.get());
+		if( event.getSeq() != m_result.received )
+			++m_result.outOfOrder;
+		if( !event.isIntact() )
+			++m_result.corrupt;
+		++m_result.received;
+	}
+
+	unsigned int getNumPings() const { return m_numPings; }
+	const BenchResult& getResult() const { return m_result; }
+};
+
+static int RunPeer( unsigned int numEvents ) {
+	EventManager manager("eventbusbench peer", false);
+	SharedEventBus bus(manager);
+	BenchPeer peer(bus);
+	bus.addPodListener(kPING_TYPE, fastdelegate::MakeDelegate(&peer, &BenchPeer::onPing));
+	manager.addListener(fastdelegate::MakeDelegate(&peer, &BenchPeer::onBenchEvent), BenchEvent::sk_EventType);
+
+	unsigned long long lastProgressNs = Clock::nowNs();
+	while( !bus.open(kSEGMENT_NAME) ) {
+		if( Clock::nowNs() - lastProgressNs > kTIMEOUT_NS )
+			return 1;
+		usleep(100);
+	}
+
+	while( peer.getNumPings() < kNUM_PINGS || peer.getResult().received < numEvents ) {
+		if( bus.poll() > 0 ) {
+			manager.update();
+			lastProgressNs = Clock::nowNs();
+		}
+		else if( Clock::nowNs() - lastProgressNs > kTIMEOUT_NS ) {
+			break;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+
+	while( !bus.sendPod(kRESULT_TYPE, peer.getResult()) )
+		std::this_thread::yield();
+	return 0;
+}//RunPeer
+
+//---------------------------------------------------------------------------------------------------------------------
+// The bench's own side of the bus.
+//---------------------------------------------------------------------------------------------------------------------
+class BenchHost {
+	std::vector<unsigned long long>		m_roundTripsNs;
+	unsigned long long					m_lastPong;
+	BenchResult							m_result;
+	bool								m_hasResult;
+
+public:
+	BenchHost() : m_lastPong(~0ULL), m_hasResult(false) { m_result = BenchResult(); }
+
+	void onPong( const EventType& type, const void* pPayload, size_t size ) {
+		(void)type;
+		(void)size;
+		const BenchPing& ping = *(const BenchPing*)pPayload;
+		m_roundTripsNs.push_back(Clock::nowNs() - ping.sentNs);
+		m_lastPong = ping.seq;
+	}
+
+	void onResult( const EventType& type, const void* pPayload, size_t size ) {
+		(void)type;
+		(void)size;
+		m_result = *(const BenchResult*)pPayload;
+		m_hasResult = true;
+	}
+
+	std::vector<unsigned long long>& getRoundTrips() { return m_roundTripsNs; }
+	unsigned long long getLastPong() const { return m_lastPong; }
+	const BenchResult& getResult() const { return m_result; }
+	bool hasResult() const { return m_hasResult; }
+};
+
+// polls until the condition holds; false if the peer stopped answering
+template <class TCondition>
+static bool PollUntil( SharedEventBus& bus, TCondition condition ) {
+	unsigned long long startNs = Clock::nowNs();
+	while( !condition() ) {
+		if( bus.poll() == 0 ) {
+			if( Clock::nowNs() - startNs > kTIMEOUT_NS )
+				return false;
+			std::this_thread::yield();
+		}
+	}
+	return true;
+}//PollUntil
+
+static unsigned long long Percentile( const std::vector<unsigned long long>& sorted, double fraction ) {
+	return sorted[(size_t)(fraction * (sorted.size() - 1))];
+}//Percentile
+
+int main( int argc, char** argv ) {
+	unsigned int numEvents = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 10) : kDEFAULT_NUM_EVENTS;
+	unsigned int ringBytes = (argc > 2) ? (unsigned int)strtoul(argv[2], NULL, 10) : kDEFAULT_RING_BYTES;
+
+	g_eventFactory.registerEvents<BenchEvent>();
+	Clock::init();
+
+	EventManager manager("eventbusbench", false);
+	SharedEventBus bus(manager);
+	if( !bus.create(kSEGMENT_NAME, ringBytes) ) {
+		fprintf(stderr, "unable to create the shared memory segment %s\n", kSEGMENT_NAME);
+		return 1;
+	}
+
+	pid_t peerPid = fork();
+	if( peerPid < 0 ) {
+		fprintf(stderr, "unable to fork the peer process\n");
+		return 1;
+	}
+	if( peerPid == 0 )
+		_exit(RunPeer(numEvents));
+
+	BenchHost host;
+	bus.addPodListener(kPONG_TYPE, fastdelegate::MakeDelegate(&host, &BenchHost::onPong));
+	bus.addPodListener(kRESULT_TYPE, fastdelegate::MakeDelegate(&host, &BenchHost::onResult));
+	bool isPeerAlive = true;
+
+	// latency: one ping in flight at a time
+	host.getRoundTrips().reserve(kNUM_PINGS);
+	for( unsigned int i = 0; i < kNUM_PINGS && isPeerAlive; ++i ) {
+		BenchPing ping;
+		ping.seq = i;
+		ping.sentNs = Clock::nowNs();
+		bus.sendPod(kPING_TYPE, ping);  // the ring is empty, so it always fits
+		isPeerAlive = PollUntil(bus, [&host, i]() { return host.getLastPong() == i; });
+	}
+
+	// throughput: stream the events as fast as the ring takes them
+	unsigned long long pingBytes = bus.getStats().bytesSent;
+	unsigned long long ringFullNs = 0;
+	unsigned long long startNs = Clock::nowNs();
+	for( unsigned int seq = 0; seq < numEvents && isPeerAlive; ++seq ) {
+		IEventDataPtr pEvent(new BenchEvent(seq));
+		if( bus.send(pEvent) )
+			continue;
+
+		unsigned long long fullNs = Clock::nowNs();
+		while( !bus.send(pEvent) ) {
+			std::this_thread::yield();
+			if( Clock::nowNs() - fullNs > kTIMEOUT_NS ) {
+				isPeerAlive = false;
+				break;
+			}
+		}
+		ringFullNs += Clock::nowNs() - fullNs;
+	}
+	isPeerAlive = isPeerAlive && PollUntil(bus, [&host]() { return host.hasResult(); });
+	unsigned long long elapsedNs = Clock::nowNs() - startNs;
+
+	int peerStatus = 0;
+	waitpid(peerPid, &peerStatus, 0);
+	if( !isPeerAlive ) {
+		fprintf(stderr, "the peer process stopped responding\n");
+		return 1;
+	}
+
+	std::vector<unsigned long long>& roundTrips = host.getRoundTrips();
+	std::sort(roundTrips.begin(), roundTrips.end());
+	unsigned long long totalNs = 0;
+	for( size_t i = 0; i < roundTrips.size(); ++i )
+		totalNs += roundTrips[i];
+
+	const SharedEventBusStats& stats = bus.getStats();
+	const BenchResult& result = host.getResult();
+	unsigned long long streamBytes = stats.bytesSent - pingBytes;
+	printf("ring %u bytes, %u pings, %u events\n", bus.getRingBytes(), kNUM_PINGS, numEvents);
+	printf("round trip    mean %llu ns  p50 %llu ns  p99 %llu ns  max %llu ns\n", totalNs / roundTrips.size(),
+		Percentile(roundTrips, 0.5), Percentile(roundTrips, 0.99), roundTrips.back());
+	printf("throughput    %.2f M events/s  %.1f MB/s  (%.1f%% of the time the ring was full)\n",
+		numEvents * 1000.0 / elapsedNs, streamBytes * 1000.0 / elapsedNs, ringFullNs * 100.0 / elapsedNs);
+	printf("ring wrapped  about %llu times\n", stats.bytesSent / bus.getRingBytes());
+	printf("received      %llu of %u, %llu out of order, %llu corrupt\n", result.received, numEvents, result.outOfOrder, result.corrupt);
+
+	bool isIntact = (result.received == numEvents && result.outOfOrder == 0 && result.corrupt == 0 && peerStatus == 0);
+	return isIntact ? 0 : 1;
+}//main
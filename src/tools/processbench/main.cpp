@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "process/processmanager.h"
+#include "utilities/clock.h"
+
+//---------------------------------------------------------------------------------------------------------------------
+// Benchmark of ProcessManager::updateProcesses() against the number of processes.  For each count it measures a tick
+// with every process running, and one with 90% of them asleep, which the tick shouldn't touch.  The processes are
+// allocated between throwaway ones, so they are scattered in memory like they would be after a while in a game.
+//
+// Before the bench it runs regression checks of tick paths that have broken before, and exits with 1 if one fails.
+// They're best run in a build with -fsanitize=address.
+//
+// Usage: processbench [numTicks]
+//---------------------------------------------------------------------------------------------------------------------
+
+using namespace genesis;
+
+static const unsigned int kPROCESS_COUNTS[] = { 1000, 10000, 50000 };
+static const unsigned int kDEFAULT_NUM_TICKS = 100;
+static const unsigned long kTICK_MS = 16;
+static const unsigned long kLONG_SLEEP_MS = 1000000000;  // never wakes during the bench
+
+class BenchProcess : public Process {
+	unsigned long		m_totalMs;
+	bool				m_isSleeper;
+
+public:
+	explicit BenchProcess( bool isSleeper ) : m_totalMs(0), m_isSleeper(isSleeper) {}
+
+	unsigned long getTotalMs() const { return m_totalMs; }
+
+protected:
+	virtual void onUpdate( unsigned long deltaMs ) {
+		m_totalMs += deltaMs;
+		if( m_isSleeper )
+			getManager()->sleep(*this, kLONG_SLEEP_MS);
+	}
+};
+
+// a serialized process that succeeds after a number of updates
+class SerializedProcess : public Process {
+	unsigned int		m_numUpdates;
+	unsigned int		m_succeedAfter;
+
+public:
+	SerializedProcess( unsigned long dataKey, unsigned int succeedAfter ) : m_numUpdates(0), m_succeedAfter(succeedAfter) {
+		setConcurrency(PROCESS_SERIALIZED, dataKey);
+	}
+
+	unsigned int getNumUpdates() const { return m_numUpdates; }
+
+protected:
+	virtual void onUpdate( unsigned long deltaMs ) {
+		(void)deltaMs;
+		if( ++m_numUpdates == m_succeedAfter )
+			succeed();
+	}
+};
+
+//---------------------------------------------------------------------------------------------------------------------
+// A serialized process wakes another whose group was dropped while it slept, from the sweep of its own group, right
+// when the array of groups is full.  The woken process's new group moves the groups while the sweep is walking one.
+//---------------------------------------------------------------------------------------------------------------------
+static bool CheckWakeFromGroupSweep() {
+	ProcessManager manager;
+	std::shared_ptr<SerializedProcess> pWaiter = std::make_shared<SerializedProcess>(1, 0);
+	std::shared_ptr<SerializedProcess> pTarget = std::make_shared<SerializedProcess>(2, 3);
+	manager.attachProcess(pWaiter);
+	manager.attachProcess(pTarget);
+	manager.updateProcesses(kTICK_MS);
+
+	if( !manager.sleepUntilDone(*pWaiter, *pTarget) )
+		return false;
+	manager.updateProcesses(kTICK_MS);  // drops the waiter's group
+	manager.attachProcess(std::make_shared<SerializedProcess>(3, 0));  // fills the groups back up next tick
+	for( unsigned int i = 0; i < 3; ++i )
+		manager.updateProcesses(kTICK_MS);
+
+	bool isOk = (pTarget->getState() == Process::SUCCEEDED && pWaiter->getState() == Process::RUNNING && pWaiter->getNumUpdates() > 1);
+	manager.abortAllProcesses(true);
+	return isOk;
+}//CheckWakeFromGroupSweep
+
+struct BenchResult {
+	unsigned long long	bestNs;
+	unsigned long long	medianNs;
+	unsigned int		running;
+	unsigned int		sleeping;
+	unsigned long		heapAllocations;  // over all the measured ticks
+};
+
+static BenchResult RunBench( unsigned int numProcesses, unsigned int sleeperEvery, unsigned int numTicks ) {
+	ProcessManager manager;
+	std::vector<StrongProcessPtr> scatter;
+	for( unsigned int i = 0; i < numProcesses; ++i ) {
+		bool isSleeper = (sleeperEvery > 0) && (i % sleeperEvery != 0);
+		manager.attachProcess(std::make_shared<BenchProcess>(isSleeper));
+		scatter.push_back(std::make_shared<BenchProcess>(false));
+	}
+	scatter.clear();
+
+	// the first ticks initialize the processes and put the sleepers to sleep
+	manager.updateProcesses(kTICK_MS);
+	manager.updateProcesses(kTICK_MS);
+
+	BenchResult result = BenchResult();
+	std::vector<unsigned long long> tickNs;
+	tickNs.reserve(numTicks);
+	for( unsigned int i = 0; i < numTicks; ++i ) {
+		unsigned long long startNs = Clock::nowNs();
+		const ProcessTickStats& stats = manager.updateProcesses(kTICK_MS);
+		tickNs.push_back(Clock::nowNs() - startNs);
+
+		result.running = stats.running;
+		result.sleeping = stats.sleeping;
+		result.heapAllocations += stats.heapAllocations;
+	}
+
+	std::sort(tickNs.begin(), tickNs.end());
+	result.bestNs = tickNs.front();
+	result.medianNs = tickNs[tickNs.size() / 2];
+
+	manager.abortAllProcesses(true);
+	return result;
+}//RunBench
+
+int main( int argc, char** argv ) {
+	unsigned int numTicks = (argc > 1) ? (unsigned int)strtoul(argv[1], NULL, 10) : kDEFAULT_NUM_TICKS;
+	if( numTicks == 0 )
+		numTicks = 1;
+
+	Clock::init();
+
+	bool isWakeFromGroupSweepOk = CheckWakeFromGroupSweep();
+	printf("check: wake from a serialized group's sweep ... %s\n", isWakeFromGroupSweepOk ? "ok" : "FAILED");
+	if( !isWakeFromGroupSweepOk )
+		return 1;
+
+	printf("%10s %10s %10s %12s %12s %12s %8s\n", "processes", "running", "sleeping", "best us", "median us", "ns/running", "allocs");
+	for( unsigned int i = 0; i < sizeof(kPROCESS_COUNTS) / sizeof(kPROCESS_COUNTS[0]); ++i ) {
+		for( unsigned int sleeperEvery = 0; sleeperEvery <= 10; sleeperEvery += 10 ) {
+			BenchResult result = RunBench(kPROCESS_COUNTS[i], sleeperEvery, numTicks);
+			printf("%10u %10u %10u %12.1f %12.1f %12.1f %8lu\n", kPROCESS_COUNTS[i], result.running, result.sleeping,
+				result.bestNs / 1000.0, result.medianNs / 1000.0, (double)result.medianNs / (result.running ? result.running : 1),
+				result.heapAllocations);
+		}
+	}
+
+	return 0;
+}//main